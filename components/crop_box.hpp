@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+
+#include "data_models/types.hpp"
+#include "imgui.h"
+
+namespace components {
+
+struct CropBox {
+    types::Region region{};
+
+    /** Controls of the region within a dataset of size d. Returns true when the region changed. */
+    bool render(const types::Dimensions& d) {
+        if (region.isEmpty()) {
+            region = types::Region::of(d);
+        }
+
+        bool changed = false;
+        changed |= ImGui::DragIntRange2("Crop x", &region.lo.x, &region.hi.x, 1.0f, 0, d.x);
+        changed |= ImGui::DragIntRange2("Crop y", &region.lo.y, &region.hi.y, 1.0f, 0, d.y);
+        changed |= ImGui::DragIntRange2("Crop z", &region.lo.z, &region.hi.z, 1.0f, 0, d.z);
+        if (ImGui::Button("Reset crop")) {
+            region = types::Region::of(d);
+            changed = true;
+        }
+
+        if (changed) {
+            // Keep at least one voxel on every axis.
+            const auto clamp = [](int& lo, int& hi, const int n) {
+                lo = std::clamp(lo, 0, n - 1);
+                hi = std::clamp(hi, lo + 1, n);
+            };
+            clamp(region.lo.x, region.hi.x, d.x);
+            clamp(region.lo.y, region.hi.y, d.y);
+            clamp(region.lo.z, region.hi.z, d.z);
+        }
+        return changed;
+    }
+};
+}  // namespace components
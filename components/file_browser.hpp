@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "data_models/frame2d.h"
+#include "data_models/types.hpp"
+#include "imgui.h"
+#include "thumbnail-index.h"
+
+namespace components {
+
+struct FileBrowser {
+    /** What the tiles show of a file; the projection itself only lives on as the texture. */
+    struct Header {
+        types::Dimensions dim;
+        storage::Error error_code;
+        bool has_error;
+    };
+
+    struct Entry {
+        std::string name;
+        std::optional<Header> header{std::nullopt};
+        std::unique_ptr<view_models::Frame2D> preview{};
+    };
+
+    static inline char directory[1024]{};
+    static inline std::optional<storage::ThumbnailIndex> index{std::nullopt};
+    static inline std::vector<Entry> entries{};
+    static inline std::optional<std::string> selection{std::nullopt};
+
+    static void open(const std::string& path) {
+        snprintf(directory, sizeof(directory), "%s", path.c_str());
+        entries.clear();
+        index.reset();
+        index.emplace(directory);
+
+        for (const auto& file : index->files()) {
+            entries.push_back({std::filesystem::path{file}.filename().string()});
+        }
+    }
+
+    /** The file the user clicked on, if any, since the last call. */
+    static std::optional<std::string> takeSelection() {
+        auto path = std::move(selection);
+        selection.reset();
+        return path;
+    }
+
+    static void render() {
+        using storage::ThumbnailIndex;
+
+        ImGui::Begin("Browse");
+        ImGui::InputText("Directory", directory, sizeof(directory));
+        ImGui::SameLine();
+        if (ImGui::Button("Scan")) {
+            open(directory);
+        }
+
+        if (!index) {
+            ImGui::End();
+            return;
+        }
+
+        // Textures can only be created on the render thread.
+        for (auto& thumbnail : index->poll()) {
+            auto& entry = entries[thumbnail.index];
+            if (!thumbnail.mip.raw.empty()) {
+                entry.preview = std::make_unique<view_models::Frame2D>(std::move(thumbnail.mip));
+            }
+            entry.header = Header{thumbnail.dim, thumbnail.error_code, thumbnail.has_error};
+        }
+
+        constexpr float tile = ThumbnailIndex::thumbnail_size;
+        const int n_columns =
+            std::max(1, static_cast<int>(ImGui::GetContentRegionAvail().x / (tile + 8.0f)));
+        for (size_t i = 0; i < entries.size(); i++) {
+            const auto& entry = entries[i];
+            ImGui::PushID(static_cast<int>(i));
+            ImGui::BeginGroup();
+
+            bool clicked = false;
+            if (entry.preview) {
+                const auto& p = *entry.preview;
+                const float zoom = tile / std::max(p.width, p.height);
+                clicked = ImGui::ImageButton("preview", p.texture,
+                                             ImVec2(p.width * zoom, p.height * zoom));
+            } else {
+                const bool failed = entry.header && entry.header->has_error;
+                clicked = ImGui::Button(failed ? "unsupported" : "...", ImVec2(tile, tile));
+            }
+            ImGui::TextUnformatted(entry.name.c_str());
+            ImGui::EndGroup();
+
+            if (entry.header && ImGui::IsItemHovered()) {
+                const auto& h = *entry.header;
+                if (h.has_error) {
+                    ImGui::SetTooltip("Unable to decode; code = %d", h.error_code);
+                } else {
+                    ImGui::SetTooltip("%d x %d x %d", h.dim.x, h.dim.y, h.dim.z);
+                }
+            }
+
+            if (clicked && entry.header && !entry.header->has_error) {
+                selection = index->files()[i];
+            }
+
+            ImGui::PopID();
+            if ((i + 1) % n_columns != 0) {
+                ImGui::SameLine();
+            }
+        }
+
+        ImGui::End();
+    }
+};
+
+}  // namespace components
@@ -1,24 +1,25 @@
 #pragma once
-#include <optional>
+#include <memory>
 
 #include "data_models/frame2d.h"
 #include "imgui.h"
-#include "view_models/scale.hpp"
 
 namespace components {
 
 struct ImageViewer {
-    static inline std::optional<view_models::Frame2D> frame{std::nullopt};
-    static void render() {
-        using view_models::scale;
+    std::shared_ptr<const view_models::Frame2D> frame{};
+    float scale{1.0f};
+
+    void render(const char title[]) {
         if (!frame) {
             return;
         }
 
-        ImGui::Begin("New image");
+        ImGui::Begin(title);
+        ImGui::SliderFloat("Scale", &scale, 0.0f, 10.0f);
         ImGui::Image(frame->texture, ImVec2(frame->width * scale, frame->height * scale));
         ImGui::End();
     }
 };
 
-}  // namespace components
\ No newline at end of file
+}  // namespace components
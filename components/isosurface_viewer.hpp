@@ -0,0 +1,187 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+
+#include "data_models/isosurface.h"
+#include "data_models/mesh3d.h"
+#include "data_models/types.hpp"
+#include "imgui.h"
+#include "view_models/resource_cache.h"
+
+namespace {
+
+/** Render a mesh in voxel coordinates at the same size and orientation as drawGL3D. */
+void
+drawMesh(const view_models::Mesh3D& mesh, const types::Dimensions& dim,
+         const types::VoxelSize& voxel_size, float scale, types::Orientation o) {
+    // Same view as the slices, with room in depth for the corners of the rotated volume.
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(-1.0, 1.0, -1.0, 1.0, -2.0, 2.0);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    constexpr std::array<GLfloat, 4> headlight{0.0f, 0.0f, 1.0f, 0.0f};
+    glLightfv(GL_LIGHT0, GL_POSITION, headlight.data());
+
+    // The inverse of the texture matrix of drawGL3D, from dataset to slice coordinates.
+    glScalef(2.0f, 2.0f, 2.0f);
+    o.normalize();
+    glRotatef(o.elevation, 1, 0, 0);
+    glRotatef(-o.azimuth, 0, 1, 0);
+    glRotatef(-90, 1, 0, 0);
+    {
+        const auto [dx, dy, dz] = voxel_size;
+        const float vmax = std::max(std::max(dx, dy), dz);
+        glScalef(vmax / dx * scale, vmax / dy * scale, vmax / dz * scale);
+    }
+    glTranslatef(-0.5f, -0.5f, -0.5f);
+    glScalef(1.0f / dim.x, 1.0f / dim.y, 1.0f / dim.z);
+    glTranslatef(0.5f, 0.5f, 0.5f);  // Voxel centers
+
+    glDisable(GL_TEXTURE_3D);
+    glDisable(GL_BLEND);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_NORMALIZE);
+    glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+    glEnable(GL_COLOR_MATERIAL);
+    glColor3f(0.9f, 0.85f, 0.75f);
+
+    mesh.draw();
+
+    glDisable(GL_COLOR_MATERIAL);
+    glDisable(GL_NORMALIZE);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+}  // namespace
+
+namespace components {
+
+struct IsosurfaceViewer {
+    bool enabled{false};
+    int threshold{128};
+    std::optional<view_models::Mesh3D> mesh{std::nullopt};
+
+    IsosurfaceViewer() = default;
+    ~IsosurfaceViewer() { reset(); }
+
+    IsosurfaceViewer(const IsosurfaceViewer&) = delete;
+    IsosurfaceViewer& operator=(const IsosurfaceViewer&) = delete;
+
+    /** Viewer window controls. Uploads the finished extraction, and starts the next one when the
+     * threshold or the crop box moved; a dragged slider thus only queues its latest value. */
+    void renderControls(const std::shared_ptr<const view_models::VolumeResource>& resource,
+                        const types::Region& region) {
+        if (!resource) {
+            return;
+        }
+        if (resource != source) {
+            reset();
+            source = resource;
+        }
+
+        ImGui::Checkbox("Isosurface", &enabled);
+        if (!enabled) {
+            return;
+        }
+        ImGui::SameLine();
+        ImGui::SliderInt("Threshold", &threshold, 1, 255);
+
+        using namespace std::chrono_literals;
+        if (pending.valid() && pending.wait_for(0s) == std::future_status::ready) {
+            const auto result = pending.get();
+            if (mesh) {
+                mesh->update(result.mesh);
+            } else {
+                mesh.emplace(result.mesh);
+            }
+            shown = requested;
+            n_triangles = result.mesh.indices.size() / 3;
+            extraction_ms = result.ms;
+        }
+
+        const Request wanted{threshold, region};
+        if (!pending.valid() && !(shown && *shown == wanted)) {
+            if (!extractor) {
+                extractor.emplace(source->volume);
+            }
+
+            requested = wanted;
+            pending = std::async(std::launch::async, [e = &*extractor, wanted]() {
+                const auto start = std::chrono::steady_clock::now();
+                auto m = e->extract(static_cast<uint8_t>(wanted.threshold), wanted.region);
+                const std::chrono::duration<float, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - start;
+                return Result{std::move(m), elapsed.count()};
+            });
+        }
+
+        ImGui::Text("%zu triangles in %.0f ms%s", n_triangles, extraction_ms,
+                    pending.valid() ? " (updating)" : "");
+    }
+
+    void render(const float scale, const types::Orientation& orientation) const {
+        if (!mesh || !source) {
+            return;
+        }
+
+        const auto& volume = source->volume;
+        drawMesh(*mesh, volume.dim, volume.voxel_size, scale, orientation);
+    }
+
+    /** Drop everything derived from the current volume, and let go of it. */
+    void reset() {
+        if (pending.valid()) {
+            pending.wait();
+        }
+        pending = {};
+        extractor.reset();
+        source.reset();
+        mesh.reset();
+        shown.reset();
+        n_triangles = 0;
+        extraction_ms = 0.0f;
+    }
+
+   private:
+    struct Request {
+        int threshold;
+        types::Region region;
+
+        bool operator==(const Request& r) const {
+            return threshold == r.threshold && region == r.region;
+        }
+    };
+
+    struct Result {
+        data_models::Mesh mesh;
+        float ms;
+    };
+
+    // Declared in order of dependency, so that the pending extraction finishes first.
+    std::shared_ptr<const view_models::VolumeResource> source{};
+    std::optional<data_models::IsosurfaceExtractor> extractor{std::nullopt};
+    std::future<Result> pending{};
+    Request requested{};
+    std::optional<Request> shown{std::nullopt};
+    size_t n_triangles{0};
+    float extraction_ms{0.0f};
+};
+}  // namespace components
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "data_models/buffer.hpp"
+#include "imgui.h"
+
+namespace components {
+
+struct MemoryUsage {
+    static void render() {
+        if (!ImGui::CollapsingHeader("Memory")) {
+            return;
+        }
+
+        constexpr float MiB = 1024.0f * 1024.0f;
+        const auto row = [&](const char label[], const memory::Usage& u) {
+            ImGui::Text("%-8s %8.1f MiB (peak %8.1f MiB)", label, u.current / MiB, u.peak / MiB);
+        };
+        for (int s = 0; s < memory::N_SUBSYSTEMS; s++) {
+            row(memory::name(static_cast<memory::Subsystem>(s)), memory::usage[s]);
+        }
+        row("total", memory::total);
+    }
+};
+}  // namespace components
@@ -2,11 +2,22 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <memory>
 #include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "components/crop_box.hpp"
+#include "components/isosurface_viewer.hpp"
 #include "data_models/frame3d.h"
 #include "data_models/types.hpp"
-#include "view_models/scale.hpp"
+#include "imgui.h"
+#include "view_models/resource_cache.h"
 
 namespace {
 void
@@ -36,6 +47,48 @@ setGLAlphaBlending(const types::BlendMode blend_mode, const float alpha,
     }
 }
 
+using Mat4 = std::array<GLfloat, 16>;  // Column-major, as in glGetFloatv
+
+/** Clip the slices to the region of interest. Planes are given in terms of the slice vertex,
+ * where p = k * v maps the vertex to normalized dataset coordinates. */
+void
+setGLClipPlanes(const Mat4& k, const types::Vec3<float>& lo, const types::Vec3<float>& hi) {
+    const std::array<float, 3> bounds_lo{lo.x, lo.y, lo.z};
+    const std::array<float, 3> bounds_hi{hi.x, hi.y, hi.z};
+    for (int i = 0; i < 3; i++) {
+        const std::array<GLdouble, 4> above{k[i], k[4 + i], k[8 + i], k[12 + i] - bounds_lo[i]};
+        const std::array<GLdouble, 4> below{-k[i], -k[4 + i], -k[8 + i],
+                                            bounds_hi[i] - k[12 + i]};
+        glClipPlane(GL_CLIP_PLANE0 + 2 * i, above.data());
+        glClipPlane(GL_CLIP_PLANE0 + 2 * i + 1, below.data());
+        glEnable(GL_CLIP_PLANE0 + 2 * i);
+        glEnable(GL_CLIP_PLANE0 + 2 * i + 1);
+    }
+}
+
+/** Range of the slice texture coordinate tz that intersects the box [lo, hi], where p = m * tc
+ * maps the texture coordinate to normalized dataset coordinates. */
+std::pair<float, float>
+sliceRange(const Mat4& m, const types::Vec3<float>& lo, const types::Vec3<float>& hi) {
+    // Row z of the inverse of the linear part is (column x) cross (column y) / determinant.
+    const std::array<float, 3> row{m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6],
+                                   m[0] * m[5] - m[1] * m[4]};
+    const float det = row[0] * m[8] + row[1] * m[9] + row[2] * m[10];
+
+    float tz_min = 1.0f;
+    float tz_max = 0.0f;
+    for (int corner = 0; corner < 8; corner++) {
+        const float px = (corner & 1) ? hi.x : lo.x;
+        const float py = (corner & 2) ? hi.y : lo.y;
+        const float pz = (corner & 4) ? hi.z : lo.z;
+        const float tz =
+            (row[0] * (px - m[12]) + row[1] * (py - m[13]) + row[2] * (pz - m[14])) / det;
+        tz_min = std::min(tz_min, tz);
+        tz_max = std::max(tz_max, tz);
+    }
+    return {std::max(tz_min, 0.0f), std::min(tz_max, 1.0f)};
+}
+
 /** volume render using a single 3D texture */
 void
 drawGL3D(const view_models::Frame3D& volume, float scale, types::Orientation o, float quality) {
@@ -55,14 +108,49 @@ drawGL3D(const view_models::Frame3D& volume, float scale, types::Orientation o,
 
     glTranslatef(-0.5f, -0.5f, -0.5f);
 
+    // So far, the texture matrix maps the slices into the whole dataset. Only the window of it is
+    // resident in the texture, and only the region within the window is to be drawn.
+    Mat4 m{};
+    glGetFloatv(GL_TEXTURE_MATRIX, m.data());
+
+    const auto [x, y, z] = volume.dim;
+    const auto normalized = [&](const types::Vec3<int>& v) -> types::Vec3<float> {
+        return {float(v.x) / x, float(v.y) / y, float(v.z) / z};
+    };
+    const auto lo = normalized(volume.region.lo);
+    const auto hi = normalized(volume.region.hi);
+    {
+        const auto [wx, wy, wz] = volume.window.size();
+        const auto [ox, oy, oz] = volume.window.lo;
+        glLoadIdentity();
+        glTranslatef(-float(ox) / wx, -float(oy) / wy, -float(oz) / wz);
+        glScalef(float(x) / wx, float(y) / wy, float(z) / wz);
+        glMultMatrixf(m.data());
+    }
+
+    // Slice vertices are v = 2 * tc - (1, 1, 1.2); fold that into the clip planes.
+    Mat4 k = m;
+    for (int i = 0; i < 3; i++) {
+        k[12 + i] += 0.5f * (m[i] + m[4 + i]) + 0.6f * m[8 + i];
+        k[i] *= 0.5f;
+        k[4 + i] *= 0.5f;
+        k[8 + i] *= 0.5f;
+    }
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    setGLClipPlanes(k, lo, hi);
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_3D, volume.texture);
     glEnable(GL_TEXTURE_3D);
-    const auto [x, y, z] = volume.dim;
     const auto render_quality = 1.7f * 1.0f / (x + y + z) * quality;
-    for (auto fz = -0.5f; fz <= 0.5f; fz += render_quality) {
-        const float tz = fz + 0.5f;
-        const float vz = (fz * 2.0f) - 0.2f;
+
+    // Skip the slices that miss the region entirely, keeping the others at the same depth as
+    // without cropping.
+    const auto [tz_min, tz_max] = sliceRange(m, lo, hi);
+    const auto first_slice = std::ceil(tz_min / render_quality);
+    for (auto tz = first_slice * render_quality; tz <= tz_max; tz += render_quality) {
+        const float vz = (tz * 2.0f) - 1.2f;
 
         glBegin(GL_QUADS);
         glTexCoord3f(0.0f, 0.0f, tz);
@@ -75,22 +163,140 @@ drawGL3D(const view_models::Frame3D& volume, float scale, types::Orientation o,
         glVertex3f(-1.0f, 1.0f, vz);
         glEnd();
     }
+
+    for (int i = 0; i < 6; i++) {
+        glDisable(GL_CLIP_PLANE0 + i);
+    }
 }
 
 }  // namespace
 
 namespace components {
 
+/** One view of a volume. Views of the same source and level share the voxels from the cache, and
+ * views cropped alike also share the texture; the settings, the crop box and the isosurface are per
+ * view. */
 struct VolumeViewer {
-    static inline types::BlendMode blend_mode{types::ATTENUATE};
-    static inline float volume_step_size{1.0f};
-    static inline float alpha{5e-3f};
-    static inline types::Orientation orientation{};
-    static inline std::optional<view_models::Frame3D> volume{std::nullopt};
-
-    static void render() {
-        using view_models::scale;
-        if (!volume) {
+    types::BlendMode blend_mode{types::ATTENUATE};
+    float volume_step_size{1.0f};
+    float alpha{5e-3f};
+    types::Orientation orientation{};
+    float scale{1.0f};
+
+    view_models::ResourceKey key{};
+    std::shared_ptr<const view_models::VolumeResource> resource{};
+
+    CropBox crop{};
+    IsosurfaceViewer isosurface{};
+
+    bool open{true};      // Cleared by the close button of the window
+    bool focused{false};  // The window had the focus in the last frame
+
+    /** Switch to another resource; the crop box and the isosurface start over. */
+    void show(const view_models::ResourceKey& k,
+              std::shared_ptr<const view_models::VolumeResource> r) {
+        isosurface.reset();
+        texture.reset();
+        crop.region = {};
+        key = k;
+        resource = std::move(r);
+    }
+
+    /** Source and level picked in the window since the last call, to be loaded by the caller. */
+    std::optional<view_models::ResourceKey> takeRequest() {
+        return std::exchange(request, std::nullopt);
+    }
+
+    /** Controls in a window of their own. Cached volumes are offered for a quick switch, and the
+     * texture of the crop box is taken from the cache. */
+    void renderControls(const char title[], view_models::ResourceCache& cache) {
+        ImGui::Begin(title, &open);
+        focused = ImGui::IsWindowFocused();
+        const auto cached = cache.volumes();
+
+        {
+            const auto label = [](const std::string& source) {
+                return std::filesystem::path(source).filename().string();
+            };
+            if (ImGui::BeginCombo("Dataset", label(key.source).c_str())) {
+                // Every source is listed once, whatever its cached levels; the level stays.
+                std::vector<std::string> listed{};
+                for (const auto& k : cached) {
+                    if (std::find(listed.begin(), listed.end(), k.source) != listed.end()) {
+                        continue;
+                    }
+                    listed.push_back(k.source);
+
+                    const bool selected = k.source == key.source;
+                    if (ImGui::Selectable(label(k.source).c_str(), selected) && !selected) {
+                        request = view_models::ResourceKey{k.source, key.level};
+                    }
+                }
+                ImGui::EndCombo();
+            }
+
+            int level = key.level;
+            if (ImGui::SliderInt("Level", &level, 0, max_level) && level != key.level) {
+                request = view_models::ResourceKey{key.source, level};
+            }
+        }
+
+        ImGui::Text("Blend mode");
+
+        {
+            using namespace types;
+            const auto radioButton = [&](const char label[], const BlendMode value) {
+                if (ImGui::RadioButton(label, blend_mode == value)) {
+                    blend_mode = value;
+                }
+            };
+            radioButton("Normal", NORMAL);
+            ImGui::SameLine();
+            radioButton("Attenuate", ATTENUATE);
+            ImGui::SameLine();
+            radioButton("Max intensity", MAX_INTENSITY);
+        }
+
+        ImGui::SliderFloat("Scale", &scale, 0.0f, 10.0f);
+        ImGui::SliderFloat("alpha (coarse)", &alpha, 0.0f, 0.5f);
+        {
+            const float vmin = std::floor(alpha * 10.0f) / 10.0f;
+            const float vmax = std::max(std::ceil(alpha * 10.0f) / 10.0f, vmin + 0.1f) - 0.01f;
+            ImGui::SliderFloat("alpha (fine)", &alpha, vmin, vmax);
+        }
+
+        constexpr float step_size_min = std::sqrt(0.5f);
+        ImGui::SliderFloat("Step size", &volume_step_size, step_size_min, 5.0f);
+        ImGui::SliderInt("azimuth", &orientation.azimuth, 0, 360);
+        ImGui::SliderInt("elevation", &orientation.elevation, -90, 90);
+
+        if (resource) {
+            const auto& source = resource->volume;
+            if (crop.render(source.dim) || !texture) {
+                // Let go first, so that the cache may resize the texture in place if no other view
+                // holds it.
+                const auto region = texture ? texture->region : types::Region{};
+                texture.reset();
+                texture = cache.texture({key.source, key.level, crop.region}, source,
+                                        {key.source, key.level, region});
+            }
+
+            const auto [wx, wy, wz] = texture->window.size();
+            ImGui::SameLine();
+            ImGui::Text("texture = %d x %d x %d", wx, wy, wz);
+        }
+
+        isosurface.renderControls(resource, crop.region);
+        ImGui::End();
+    }
+
+    void render() const {
+        if (!resource || !texture) {
+            return;
+        }
+
+        if (isosurface.enabled) {
+            isosurface.render(scale, orientation);
             return;
         }
 
@@ -98,7 +304,13 @@ struct VolumeViewer {
         // glDisable(GL_ALPHA_TEST);
         glDisable(GL_LIGHTING);
         setGLAlphaBlending(blend_mode, alpha);
-        drawGL3D(*volume, scale, orientation, volume_step_size);
+        drawGL3D(*texture, scale, orientation, volume_step_size);
     }
+
+    static constexpr int max_level = 3;
+
+   private:
+    std::shared_ptr<const view_models::Frame3D> texture{};
+    std::optional<view_models::ResourceKey> request{std::nullopt};
 };
-}  // namespace components
\ No newline at end of file
+}  // namespace components
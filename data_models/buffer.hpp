@@ -0,0 +1,145 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace memory {
+
+/** Who currently owns a large buffer. */
+enum Subsystem {
+    READER,
+    VOLUME,
+    N_SUBSYSTEMS,
+};
+
+constexpr const char*
+name(const Subsystem s) {
+    switch (s) {
+        case READER:
+            return "reader";
+        case VOLUME:
+            return "volume";
+        default:
+            return "?";
+    }
+}
+
+/** Bytes held now, and at most since startup. */
+struct Usage {
+    std::atomic<size_t> current{0};
+    std::atomic<size_t> peak{0};
+
+    void add(const size_t bytes) {
+        const size_t now = current += bytes;
+        size_t highest = peak;
+        while (now > highest && !peak.compare_exchange_weak(highest, now)) {
+        }
+    }
+
+    void remove(const size_t bytes) { current -= bytes; }
+};
+
+inline std::array<Usage, N_SUBSYSTEMS> usage{};
+inline Usage total{};
+
+/** Source of the memory of every Buffer. */
+struct Allocator {
+    virtual ~Allocator() = default;
+    virtual void* allocate(size_t bytes) = 0;
+    virtual void deallocate(void* p, size_t bytes) = 0;
+};
+
+struct HeapAllocator final : Allocator {
+    // Cache line aligned, for the benefit of the parallel copies.
+    static constexpr std::align_val_t alignment{64};
+
+    void* allocate(const size_t bytes) override { return ::operator new(bytes, alignment); }
+    void deallocate(void* p, size_t /*bytes*/) override { ::operator delete(p, alignment); }
+};
+
+inline HeapAllocator heap_allocator{};
+
+/** Allocator of the new buffers. Atomic, since thumbnail workers allocate slab buffers in the
+ * background; each buffer loads it once and returns its memory to the allocator it came from, so
+ * this can be swapped at any time. A replaced allocator must outlive the buffers it made. */
+inline std::atomic<Allocator*> allocator{&heap_allocator};
+
+/** Move-only array of bytes, accounted to the subsystem owning it. Copies do not compile, so a
+ * voxel buffer can only ever exist once. The contents are uninitialized. */
+class Buffer {
+   public:
+    Buffer() = default;
+
+    Buffer(const size_t size, const Subsystem owner) : Buffer(size, owner, *allocator.load()) {}
+
+    ~Buffer() { release(); }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    Buffer(Buffer&& b) noexcept
+        : ptr{std::exchange(b.ptr, nullptr)},
+          n{std::exchange(b.n, 0)},
+          subsystem{b.subsystem},
+          source{b.source} {}
+
+    Buffer& operator=(Buffer&& b) noexcept {
+        if (this != &b) {
+            release();
+            ptr = std::exchange(b.ptr, nullptr);
+            n = std::exchange(b.n, 0);
+            subsystem = b.subsystem;
+            source = b.source;
+        }
+        return *this;
+    }
+
+    /** Hand the bytes over to another subsystem, without copying them. */
+    void transfer(const Subsystem owner) {
+        usage[subsystem].remove(n);
+        usage[owner].add(n);
+        subsystem = owner;
+    }
+
+    uint8_t* data() { return ptr; }
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    Subsystem owner() const { return subsystem; }
+
+    uint8_t& operator[](const size_t i) { return ptr[i]; }
+    const uint8_t& operator[](const size_t i) const { return ptr[i]; }
+
+    uint8_t* begin() { return ptr; }
+    uint8_t* end() { return ptr + n; }
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + n; }
+
+   private:
+    uint8_t* ptr{nullptr};
+    size_t n{0};
+    Subsystem subsystem{READER};
+    Allocator* source{nullptr};
+
+    Buffer(const size_t size, const Subsystem owner, Allocator& a)
+        : ptr{static_cast<uint8_t*>(a.allocate(size))}, n{size}, subsystem{owner}, source{&a} {
+        usage[subsystem].add(n);
+        total.add(n);
+    }
+
+    void release() {
+        if (ptr == nullptr) {
+            return;
+        }
+        source->deallocate(ptr, n);
+        usage[subsystem].remove(n);
+        total.remove(n);
+        ptr = nullptr;
+        n = 0;
+    }
+};
+
+}  // namespace memory
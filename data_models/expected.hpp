@@ -0,0 +1,18 @@
+#pragma once
+#include <utility>
+
+namespace types {
+
+template <typename T, typename U>
+struct Expected {
+    T value{};
+    U error_code{};
+    bool has_error{true};
+
+    constexpr Expected(U&& ec) : error_code{ec}, has_error{true} {}
+
+    template <typename V>
+    constexpr Expected(V&& value) : value{std::forward<V>(value)}, has_error{false} {}
+};
+
+}  // namespace types
@@ -30,6 +30,8 @@ Frame2D::~Frame2D() { glDeleteTextures(1, &texture); }
 
 void
 Frame2D::update(const Image& im) {
+    // Rows are tightly packed, whatever the width.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, im.width, im.height, 0, GL_RED, GL_UNSIGNED_BYTE,
                  im.raw.data());
 }
@@ -1,13 +1,65 @@
 #include "frame3d.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 
 using data_models::Volume;
+using types::Region;
+
+namespace {
+
+size_t
+voxelCount(const Region& r) {
+    const auto [x, y, z] = r.size();
+    return static_cast<size_t>(x) * y * z;
+}
+
+/** Smallest box holding both a and b. */
+Region
+boundingBox(const Region& a, const Region& b) {
+    return {{std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y), std::min(a.lo.z, b.lo.z)},
+            {std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y), std::max(a.hi.z, b.hi.z)}};
+}
+
+/** Pad the box by 1/8 of its size on every side, without leaving the dataset. */
+Region
+padded(const Region& r, const types::Dimensions& dim) {
+    const auto [sx, sy, sz] = r.size();
+    return {{std::max(r.lo.x - sx / 8, 0), std::max(r.lo.y - sy / 8, 0),
+             std::max(r.lo.z - sz / 8, 0)},
+            {std::min(r.hi.x + sx / 8, dim.x), std::min(r.hi.y + sy / 8, dim.y),
+             std::min(r.hi.z + sz / 8, dim.z)}};
+}
+
+/** Split outer minus inner into at most 6 non-overlapping boxes; inner must lie inside outer. */
+template <typename F>
+void
+forEachShell(const Region& outer, const Region& inner, F&& f) {
+    const auto emit = [&](const Region& r) {
+        if (!r.isEmpty()) {
+            f(r);
+        }
+    };
+
+    const auto& [a, b] = outer;
+    const auto& [c, d] = inner;
+    emit({{a.x, a.y, a.z}, {b.x, b.y, c.z}});  // Below
+    emit({{a.x, a.y, d.z}, {b.x, b.y, b.z}});  // Above
+    emit({{a.x, a.y, c.z}, {b.x, c.y, d.z}});  // Front
+    emit({{a.x, d.y, c.z}, {b.x, b.y, d.z}});  // Back
+    emit({{a.x, c.y, c.z}, {c.x, d.y, d.z}});  // Left
+    emit({{d.x, c.y, c.z}, {b.x, d.y, d.z}});  // Right
+}
+
+}  // namespace
 
 namespace view_models {
-Frame3D::Frame3D(const Volume& im) : dim{im.dim}, voxel_size{im.voxel_size}, texture{0} {
-    assert(im.isValid());
+Frame3D::Frame3D(const Volume& im) : Frame3D(im, Region::of(im.dim)) {}
+
+Frame3D::Frame3D(const Volume& im, const Region& roi)
+    : dim{im.dim}, voxel_size{im.voxel_size}, texture{0}, region{roi}, window{roi}, valid{roi} {
+    assert(im.isValid() && Region::of(dim).contains(roi) && !roi.isEmpty());
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_3D, texture);
 
@@ -30,8 +82,15 @@ Frame3D::Frame3D(const Volume& im) : dim{im.dim}, voxel_size{im.voxel_size}, tex
     // glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
     glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 
-    const auto [x, y, z] = dim;
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, x, y, z, 0, GL_RED, GL_UNSIGNED_BYTE, im.buffer.data());
+    if (roi == Region::of(dim)) {
+        // The whole volume goes up as is, without staging.
+        const auto [x, y, z] = dim;
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, x, y, z, 0, GL_RED, GL_UNSIGNED_BYTE,
+                     im.buffer.data());
+    } else {
+        allocate(padded(roi, dim));
+        upload(im, roi);
+    }
 
     // In-place conversion from grayscale to RGBA.
     constexpr std::array<GLint, 4> swizzleMask{GL_RED, GL_RED, GL_RED, GL_ONE};
@@ -39,4 +98,57 @@ Frame3D::Frame3D(const Volume& im) : dim{im.dim}, voxel_size{im.voxel_size}, tex
 }
 
 Frame3D::~Frame3D() { glDeleteTextures(1, &texture); }
-}  // namespace view_models
\ No newline at end of file
+
+void
+Frame3D::setRegion(const Volume& im, const Region& roi) {
+    assert(im.isValid() && Region::of(dim).contains(roi) && !roi.isEmpty());
+    region = roi;
+    glBindTexture(GL_TEXTURE_3D, texture);
+
+    // Reallocate when the box outgrows the texture, or when the texture is mostly unused.
+    const auto wanted = padded(roi, dim);
+    if (!window.contains(roi) || voxelCount(window) > 2 * voxelCount(wanted)) {
+        allocate(wanted);
+        valid = roi;
+        upload(im, roi);
+        return;
+    }
+
+    // Otherwise, only send the shell of voxels between the resident box and the new one.
+    const auto grown = boundingBox(valid, roi);
+    forEachShell(grown, valid, [&](const Region& r) { upload(im, r); });
+    valid = grown;
+}
+
+void
+Frame3D::allocate(const Region& r) {
+    window = r;
+    const auto [x, y, z] = r.size();
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, x, y, z, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+}
+
+void
+Frame3D::upload(const Volume& im, const Region& r) {
+    assert(window.contains(r));
+
+    // Read the sub-volume in place, striding over the rows and slices of the whole dataset, so
+    // that no staging copy is made; rows of a sub-volume are not 4-byte aligned in general.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, dim.x);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, dim.y);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, r.lo.x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, r.lo.y);
+    glPixelStorei(GL_UNPACK_SKIP_IMAGES, r.lo.z);
+
+    const auto [x, y, z] = r.size();
+    glTexSubImage3D(GL_TEXTURE_3D, 0, r.lo.x - window.lo.x, r.lo.y - window.lo.y,
+                    r.lo.z - window.lo.z, x, y, z, GL_RED, GL_UNSIGNED_BYTE, im.buffer.data());
+
+    // Back to tightly packed pixels, which every other upload assumes.
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_IMAGES, 0);
+}
+}  // namespace view_models
@@ -10,11 +10,30 @@ struct Frame3D {
     types::VoxelSize voxel_size;
     GLuint texture;
 
+    /** Voxels to render, in dataset coordinates. */
+    types::Region region;
+
+    /** Voxels covered by the texture; larger than the region so that growing it stays cheap. */
+    types::Region window;
+
+    /** Voxels of the window that have been uploaded. */
+    types::Region valid;
+
     Frame3D(const data_models::Volume& im);
+
+    /** Upload only the sub-volume roi of im, as if constructed whole and then cropped. */
+    Frame3D(const data_models::Volume& im, const types::Region& roi);
     ~Frame3D();
 
     Frame3D(const Frame3D&) = delete;
     Frame3D& operator=(const Frame3D&) = delete;
+
+    /** Restrict rendering to a sub-volume of im, uploading only the voxels not yet resident. */
+    void setRegion(const data_models::Volume& im, const types::Region& roi);
+
+   private:
+    void allocate(const types::Region& r);
+    void upload(const data_models::Volume& im, const types::Region& r);
 };
 
-}  // namespace view_models
\ No newline at end of file
+}  // namespace view_models
@@ -0,0 +1,374 @@
+#include "isosurface.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+#include "parallel.hpp"
+
+using types::Dimensions;
+using types::Region;
+using types::Vec3;
+
+namespace {
+
+/** Corners of a cell are numbered x + 2y + 4z. A cube edge is the lower corner and the axis. */
+struct CubeEdge {
+    int corner;
+    int axis;
+};
+
+constexpr int
+bitOf(const int corner, const int axis) {
+    return (corner >> axis) & 1;
+}
+
+/** Index of a cube edge in [0, 12): four edges per axis. */
+constexpr int
+edgeIndex(const int lower_corner, const int axis) {
+    const int others = (lower_corner & ((1 << axis) - 1)) | ((lower_corner >> (axis + 1)) << axis);
+    return axis * 4 + others;
+}
+
+constexpr std::array<CubeEdge, 12>
+cubeEdges() {
+    std::array<CubeEdge, 12> edges{};
+    for (int corner = 0; corner < 8; corner++) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (bitOf(corner, axis) == 0) {
+                edges[edgeIndex(corner, axis)] = {corner, axis};
+            }
+        }
+    }
+    return edges;
+}
+
+constexpr auto cube_edges = cubeEdges();
+
+using CaseTable = std::array<std::vector<int>, 256>;  // Cube edges, three per triangle
+
+/** Generate the triangles of all 256 cases, instead of transcribing the classic table.
+ *
+ * On every face, walking its corners counter-clockwise as seen from outside the cell, the
+ * surface enters the inside at one cut edge and leaves it at the next cut edge. Joining each entry
+ * to the following exit separates the inside corners of ambiguous faces. Since the choice only
+ * depends on the face, both cells sharing a face agree on it, and the surface is watertight.
+ * Chaining the segments of all faces yields closed loops, consistently oriented so that the
+ * triangles face the outside. */
+CaseTable
+makeCaseTable() {
+    // Faces, with corners in counter-clockwise order as seen from outside.
+    std::array<std::array<int, 4>, 6> faces{};
+    for (int axis = 0; axis < 3; axis++) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        for (int side = 0; side < 2; side++) {
+            auto& face = faces[axis * 2 + side];
+            face = {side << axis, (side << axis) | (1 << u), (side << axis) | (1 << u) | (1 << v),
+                    (side << axis) | (1 << v)};
+            // (u, v, axis) is right handed, so this order faces +axis.
+            if (side == 0) {
+                std::swap(face[1], face[3]);
+            }
+        }
+    }
+
+    // Faces touching an edge, as bits axis * 2 + side.
+    const auto faceMask = [](const int edge) {
+        const auto [corner, axis] = cube_edges[edge];
+        int mask = 0;
+        for (int a = 0; a < 3; a++) {
+            if (a != axis) {
+                mask |= 1 << (a * 2 + bitOf(corner, a));
+            }
+        }
+        return mask;
+    };
+
+    CaseTable table{};
+    for (int inside = 0; inside < 256; inside++) {
+        const auto isInside = [&](const int corner) { return (inside >> corner) & 1; };
+
+        std::array<int, 12> next{};
+        next.fill(-1);
+        for (const auto& face : faces) {
+            for (int i = 0; i < 4; i++) {
+                const int a = face[i];
+                const int b = face[(i + 1) % 4];
+                if (isInside(a) || !isInside(b)) {
+                    continue;
+                }
+
+                // Entry on edge a-b; find the next exit.
+                for (int j = 1; j < 4; j++) {
+                    const int c = face[(i + j) % 4];
+                    const int d = face[(i + j + 1) % 4];
+                    if (isInside(c) && !isInside(d)) {
+                        const int entry = edgeIndex(a & b, __builtin_ctz(a ^ b));
+                        next[entry] = edgeIndex(c & d, __builtin_ctz(c ^ d));
+                        break;
+                    }
+                }
+            }
+        }
+
+        auto& triangles = table[inside];
+        std::array<bool, 12> visited{};
+        for (int start = 0; start < 12; start++) {
+            if (next[start] < 0 || visited[start]) {
+                continue;
+            }
+
+            std::vector<int> loop{};
+            for (int e = start; !visited[e]; e = next[e]) {
+                visited[e] = true;
+                loop.push_back(e);
+            }
+
+            // Fan out from a vertex whose diagonals stay off the faces: across an ambiguous face,
+            // the neighbouring cell could pick the same diagonal, and the edge would be shared by
+            // four triangles.
+            const auto l = loop.size();
+            const auto hasFaceDiagonal = [&](const size_t apex) {
+                for (size_t k = 2; k + 1 < l; k++) {
+                    if ((faceMask(loop[apex]) & faceMask(loop[(apex + k) % l])) != 0) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+            size_t apex = 0;
+            while (apex + 1 < l && hasFaceDiagonal(apex)) {
+                apex++;
+            }
+
+            for (size_t k = 1; k + 1 < l; k++) {
+                triangles.insert(triangles.end(),
+                                 {loop[apex], loop[(apex + k) % l], loop[(apex + k + 1) % l]});
+            }
+        }
+    }
+    return table;
+}
+
+const CaseTable&
+caseTable() {
+    static const CaseTable table = makeCaseTable();
+    return table;
+}
+
+/** Index of a grid edge, given its lower voxel and its axis. */
+uint64_t
+edgeId(const Dimensions& n, const int x, const int y, const int z, const int axis) {
+    return ((static_cast<uint64_t>(z) * n.y + y) * n.x + x) * 3 + axis;
+}
+
+}  // namespace
+
+namespace data_models {
+
+IsosurfaceExtractor::IsosurfaceExtractor(const Volume& v) : volume{v}, n_bricks{} {
+    assert(v.isValid());
+    const auto bricks = [](const int n) {
+        return std::max(n - 1 + brick_size - 1, 0) / brick_size;
+    };
+    n_bricks = {{bricks(v.dim.x), bricks(v.dim.y), bricks(v.dim.z)}};
+}
+
+void
+IsosurfaceExtractor::summarize() const {
+    const auto& n = volume.dim;
+    const auto& b = n_bricks;
+    brick_range.assign(static_cast<size_t>(b.count()), {255, 0});
+
+    // Each brick spans its cells' corners, so neighbouring bricks share a layer of voxels.
+    parallelFor(b.z, [&](const size_t bz) {
+        const int z_end = std::min(int(bz) * brick_size + brick_size, n.z - 1);
+        for (int z = int(bz) * brick_size; z <= z_end; z++) {
+            for (int by = 0; by < b.y; by++) {
+                const int y_end = std::min(by * brick_size + brick_size, n.y - 1);
+                for (int y = by * brick_size; y <= y_end; y++) {
+                    const auto* row = &volume.buffer[(static_cast<size_t>(z) * n.y + y) * n.x];
+                    for (int bx = 0; bx < b.x; bx++) {
+                        const auto begin = row + bx * brick_size;
+                        const auto end = row + std::min(bx * brick_size + brick_size, n.x - 1) + 1;
+                        const auto [lo, hi] = std::minmax_element(begin, end);
+                        auto& range = brick_range[(bz * b.y + by) * b.x + bx];
+                        range.first = std::min(range.first, *lo);
+                        range.second = std::max(range.second, *hi);
+                    }
+                }
+            }
+        }
+    });
+}
+
+Mesh
+IsosurfaceExtractor::extract(const uint8_t threshold, const Region& region) const {
+    std::call_once(summarized, [this]() { summarize(); });
+
+    const auto& n = volume.dim;
+    const auto& b = n_bricks;
+    const auto& v = volume.buffer;
+    Mesh mesh{};
+    if (b.count() == 0 || threshold == 0) {
+        return mesh;
+    }
+
+    const auto value = [&](const int x, const int y, const int z) {
+        return v[(static_cast<size_t>(z) * n.y + y) * n.x + x];
+    };
+
+    const auto isActive = [&](const int bx, const int by, const int bz) {
+        const auto [lo, hi] = brick_range[(static_cast<size_t>(bz) * b.y + by) * b.x + bx];
+        return lo < threshold && hi >= threshold;
+    };
+
+    // Central differences, one-sided at the border of the volume.
+    const auto gradient = [&](const int x, const int y, const int z) -> Vec3<float> {
+        const auto diff = [](const int a, const int b, const int d) { return float(b - a) / d; };
+        const int x0 = std::max(x - 1, 0), x1 = std::min(x + 1, n.x - 1);
+        const int y0 = std::max(y - 1, 0), y1 = std::min(y + 1, n.y - 1);
+        const int z0 = std::max(z - 1, 0), z1 = std::min(z + 1, n.z - 1);
+        return {diff(value(x0, y, z), value(x1, y, z), std::max(x1 - x0, 1)),
+                diff(value(x, y0, z), value(x, y1, z), std::max(y1 - y0, 1)),
+                diff(value(x, y, z0), value(x, y, z1), std::max(z1 - z0, 1))};
+    };
+
+    // Voxels [lo, hi) of the region; the cells whose corners all lie in it.
+    const auto& lo = region.lo;
+    const auto& hi = region.hi;
+    const float iso = threshold - 0.5f;
+
+    // Slab s holds the edges whose lower voxel lies in the brick layer s; the top voxel layer
+    // belongs to the last slab.
+    const int n_slabs = b.z;
+    const auto slabOf = [&](const int z) { return std::min(z / brick_size, n_slabs - 1); };
+    const auto brickOf = [&](const int i, const int n_b) {
+        return std::min(i / brick_size, n_b - 1);
+    };
+
+    struct Slab {
+        std::vector<uint64_t> edge_ids;  // Ascending
+        std::vector<Mesh::Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+    std::vector<Slab> slabs(n_slabs);
+
+    // Pass 1: one vertex per cut edge, in ascending edge order within each slab.
+    parallelFor(n_slabs, [&](const size_t s) {
+        auto& slab = slabs[s];
+        const int z_begin = std::max(int(s) * brick_size, lo.z);
+        const int z_end = std::min(int(s) + 1 == n_slabs ? n.z : int(s + 1) * brick_size, hi.z);
+        for (int z = z_begin; z < z_end; z++) {
+            const int bz = brickOf(z, b.z);
+            for (int y = lo.y; y < hi.y; y++) {
+                const int by = brickOf(y, b.y);
+                for (int x = lo.x; x < hi.x; x++) {
+                    const int bx = brickOf(x, b.x);
+                    if (!isActive(bx, by, bz)) {
+                        // Nothing is cut in the rest of this brick's row.
+                        x = bx == b.x - 1 ? hi.x - 1 : std::min((bx + 1) * brick_size, hi.x) - 1;
+                        continue;
+                    }
+
+                    const auto v0 = value(x, y, z);
+                    const std::array<int, 3> p{x, y, z};
+                    const std::array<int, 3> end{hi.x, hi.y, hi.z};
+                    for (int axis = 0; axis < 3; axis++) {
+                        if (p[axis] + 1 >= end[axis]) {
+                            continue;
+                        }
+                        auto q = p;
+                        q[axis]++;
+                        const auto v1 = value(q[0], q[1], q[2]);
+                        if ((v0 >= threshold) == (v1 >= threshold)) {
+                            continue;
+                        }
+
+                        const float t = (iso - v0) / (float(v1) - float(v0));
+                        const auto g0 = gradient(x, y, z);
+                        const auto g1 = gradient(q[0], q[1], q[2]);
+
+                        // Point the normal down the gradient, out of the bright region.
+                        Vec3<float> normal{-(g0.x + t * (g1.x - g0.x)), -(g0.y + t * (g1.y - g0.y)),
+                                           -(g0.z + t * (g1.z - g0.z))};
+                        const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y +
+                                                       normal.z * normal.z);
+                        if (length > 0.0f) {
+                            normal = {normal.x / length, normal.y / length, normal.z / length};
+                        }
+
+                        std::array<float, 3> position{float(x), float(y), float(z)};
+                        position[axis] += t;
+
+                        slab.edge_ids.push_back(edgeId(n, x, y, z, axis));
+                        slab.vertices.push_back({{position[0], position[1], position[2]}, normal});
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<uint32_t> vertex_offset(n_slabs + 1, 0);
+    for (int s = 0; s < n_slabs; s++) {
+        vertex_offset[s + 1] = vertex_offset[s] + static_cast<uint32_t>(slabs[s].vertices.size());
+    }
+
+    // Pass 2: triangles, referring to the vertices of this slab or of the one above.
+    const auto& table = caseTable();
+    parallelFor(n_slabs, [&](const size_t s) {
+        auto& slab = slabs[s];
+        const int z_begin = std::max(int(s) * brick_size, lo.z);
+        const int z_end = std::min(int(s + 1) * brick_size, hi.z - 1);
+        for (int z = z_begin; z < z_end; z++) {
+            for (int y = lo.y; y < hi.y - 1; y++) {
+                for (int x = lo.x; x < hi.x - 1; x++) {
+                    const int bx = x / brick_size;
+                    if (!isActive(bx, y / brick_size, z / brick_size)) {
+                        x = std::min((bx + 1) * brick_size, hi.x - 1) - 1;
+                        continue;
+                    }
+
+                    int inside = 0;
+                    for (int c = 0; c < 8; c++) {
+                        const auto vc = value(x + bitOf(c, 0), y + bitOf(c, 1), z + bitOf(c, 2));
+                        inside |= (vc >= threshold) << c;
+                    }
+
+                    for (const int e : table[inside]) {
+                        const auto [corner, axis] = cube_edges[e];
+                        const int ex = x + bitOf(corner, 0);
+                        const int ey = y + bitOf(corner, 1);
+                        const int ez = z + bitOf(corner, 2);
+                        const int owner = slabOf(ez);
+                        const auto& ids = slabs[owner].edge_ids;
+                        const auto it =
+                            std::lower_bound(ids.begin(), ids.end(), edgeId(n, ex, ey, ez, axis));
+                        assert(it != ids.end() && *it == edgeId(n, ex, ey, ez, axis));
+                        slab.indices.push_back(vertex_offset[owner] +
+                                               static_cast<uint32_t>(it - ids.begin()));
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<size_t> index_offset(n_slabs + 1, 0);
+    for (int s = 0; s < n_slabs; s++) {
+        index_offset[s + 1] = index_offset[s] + slabs[s].indices.size();
+    }
+
+    mesh.vertices.resize(vertex_offset[n_slabs]);
+    mesh.indices.resize(index_offset[n_slabs]);
+    parallelFor(n_slabs, [&](const size_t s) {
+        std::copy(slabs[s].vertices.begin(), slabs[s].vertices.end(),
+                  mesh.vertices.begin() + vertex_offset[s]);
+        std::copy(slabs[s].indices.begin(), slabs[s].indices.end(),
+                  mesh.indices.begin() + index_offset[s]);
+    });
+    return mesh;
+}
+
+}  // namespace data_models
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+#include "volume.hpp"
+
+namespace data_models {
+
+/** Indexed triangle mesh, in voxel coordinates. */
+struct Mesh {
+    struct Vertex {
+        types::Vec3<float> position;
+        types::Vec3<float> normal;
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;  // Three per triangle
+};
+
+/** Marching cubes over a volume, in parallel over slabs of bricks. Bricks whose intensity range
+ * does not straddle the threshold are skipped; the ranges are computed on first use and reused
+ * by every later threshold. The volume must outlive the extractor. */
+class IsosurfaceExtractor {
+   public:
+    static constexpr int brick_size = 8;  // Cells per brick, along every axis
+
+    explicit IsosurfaceExtractor(const Volume& volume);
+
+    /** Surface between the voxels below the threshold and those at or above it, restricted to a
+     * region of the volume. Vertices on edges shared by neighbouring cells are shared too.
+     * Thread-safe. */
+    [[nodiscard]] Mesh extract(uint8_t threshold, const types::Region& region) const;
+
+   private:
+    const Volume& volume;
+    types::Dimensions n_bricks;
+
+    mutable std::once_flag summarized;
+    mutable std::vector<std::pair<uint8_t, uint8_t>> brick_range;  // Min and max voxel value
+
+    void summarize() const;
+};
+
+}  // namespace data_models
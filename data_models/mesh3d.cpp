@@ -0,0 +1,76 @@
+#include "mesh3d.h"
+
+#include <cstddef>
+
+using data_models::Mesh;
+
+namespace {
+
+/** Buffer objects are newer than OpenGL 1.1, so libGL does not have to export them. */
+struct BufferFunctions {
+    PFNGLGENBUFFERSPROC genBuffers;
+    PFNGLDELETEBUFFERSPROC deleteBuffers;
+    PFNGLBINDBUFFERPROC bindBuffer;
+    PFNGLBUFFERDATAPROC bufferData;
+};
+
+const BufferFunctions&
+gl() {
+    static const BufferFunctions functions{
+        reinterpret_cast<PFNGLGENBUFFERSPROC>(glfwGetProcAddress("glGenBuffers")),
+        reinterpret_cast<PFNGLDELETEBUFFERSPROC>(glfwGetProcAddress("glDeleteBuffers")),
+        reinterpret_cast<PFNGLBINDBUFFERPROC>(glfwGetProcAddress("glBindBuffer")),
+        reinterpret_cast<PFNGLBUFFERDATAPROC>(glfwGetProcAddress("glBufferData")),
+    };
+    return functions;
+}
+
+}  // namespace
+
+namespace view_models {
+Mesh3D::Mesh3D(const Mesh& mesh) : vertex_buffer{0}, index_buffer{0}, n_indices{0} {
+    gl().genBuffers(1, &vertex_buffer);
+    gl().genBuffers(1, &index_buffer);
+    update(mesh);
+}
+
+Mesh3D::~Mesh3D() {
+    gl().deleteBuffers(1, &vertex_buffer);
+    gl().deleteBuffers(1, &index_buffer);
+}
+
+void
+Mesh3D::update(const Mesh& mesh) {
+    gl().bindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    gl().bufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Mesh::Vertex),
+                    mesh.vertices.data(), GL_STATIC_DRAW);
+    gl().bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    gl().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    gl().bufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t),
+                    mesh.indices.data(), GL_STATIC_DRAW);
+    gl().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    n_indices = static_cast<GLsizei>(mesh.indices.size());
+}
+
+void
+Mesh3D::draw() const {
+    constexpr auto stride = sizeof(Mesh::Vertex);
+    gl().bindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride,
+                    reinterpret_cast<const void*>(offsetof(Mesh::Vertex, position)));
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, stride,
+                    reinterpret_cast<const void*>(offsetof(Mesh::Vertex, normal)));
+
+    gl().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    glDrawElements(GL_TRIANGLES, n_indices, GL_UNSIGNED_INT, nullptr);
+
+    gl().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    gl().bindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+}  // namespace view_models
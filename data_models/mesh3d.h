@@ -0,0 +1,24 @@
+#pragma once
+#include <GLFW/glfw3.h>
+
+#include "data_models/isosurface.h"
+
+namespace view_models {
+struct Mesh3D {
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    GLsizei n_indices;
+
+    Mesh3D(const data_models::Mesh& mesh);
+    ~Mesh3D();
+
+    Mesh3D(const Mesh3D&) = delete;
+    Mesh3D& operator=(const Mesh3D&) = delete;
+
+    void update(const data_models::Mesh& mesh);
+
+    /** Draw with the fixed function pipeline; the matrices and lighting are up to the caller. */
+    void draw() const;
+};
+
+}  // namespace view_models
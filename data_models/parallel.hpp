@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace data_models {
+
+/** Helper threads started once and kept for the lifetime of the program, so that parallelFor
+ * costs no thread creation per call; an isosurface extraction calls it once per pass, again at
+ * every move of the threshold slider, and Volume::downsampled once per level switch. Batches from
+ * concurrent callers are served in FIFO order. */
+class WorkerPool {
+   public:
+    static WorkerPool& instance() {
+        static WorkerPool pool{std::max(1u, std::thread::hardware_concurrency()) - 1};
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    /** Call f(i) for every i in [0, n), on the calling thread and on the idle helpers. */
+    void run(const size_t n, const std::function<void(size_t)>& f) {
+        auto batch = std::make_shared<Batch>(n, f);
+        {
+            std::lock_guard lock{mutex};
+            batches.push_back(batch);
+        }
+        wake.notify_all();
+
+        batch->work();
+        retire(batch);
+
+        std::unique_lock lock{batch->mutex};
+        batch->finished.wait(lock, [&]() { return batch->completed == n; });
+    }
+
+   private:
+    struct Batch {
+        const size_t n;
+        const std::function<void(size_t)>& f;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> completed{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        Batch(const size_t n, const std::function<void(size_t)>& f) : n{n}, f{f} {}
+
+        /** Claim tasks one at a time until none is left. */
+        void work() {
+            for (size_t i = next++; i < n; i = next++) {
+                f(i);
+                if (++completed == n) {
+                    std::lock_guard lock{mutex};
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<Batch>> batches;
+    bool stopping{false};
+    std::vector<std::thread> workers;
+
+    explicit WorkerPool(const unsigned n_threads) {
+        for (unsigned i = 0; i < n_threads; i++) {
+            workers.emplace_back([this]() { help(); });
+        }
+    }
+
+    /** Drop a batch with no tasks left to claim; the threads still running its tasks keep it. */
+    void retire(const std::shared_ptr<Batch>& batch) {
+        std::lock_guard lock{mutex};
+        batches.erase(std::remove(batches.begin(), batches.end(), batch), batches.end());
+    }
+
+    void help() {
+        while (true) {
+            std::shared_ptr<Batch> batch;
+            {
+                std::unique_lock lock{mutex};
+                wake.wait(lock, [this]() { return stopping || !batches.empty(); });
+                if (stopping) {
+                    return;
+                }
+                batch = batches.front();
+            }
+            batch->work();
+            retire(batch);
+        }
+    }
+};
+
+/** Call f(i) for every i in [0, n) on all hardware threads. Tasks are claimed one at a time, so
+ * uneven tasks still balance across the threads. A single task runs on the calling thread. */
+template <typename F>
+void
+parallelFor(const size_t n, F&& f) {
+    if (n <= 1 || WorkerPool::instance().size() == 0) {
+        for (size_t i = 0; i < n; i++) {
+            f(i);
+        }
+        return;
+    }
+
+    WorkerPool::instance().run(n, std::function<void(size_t)>{std::ref(f)});
+}
+
+}  // namespace data_models
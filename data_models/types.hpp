@@ -15,6 +15,25 @@ struct Dimensions : Vec3<int> {
     constexpr int count() const { return x * y * z; }
 };
 
+/** Axis-aligned box of voxels, spanning [lo, hi) on every axis. */
+struct Region {
+    Vec3<int> lo{};
+    Vec3<int> hi{};
+
+    static constexpr Region of(const Dimensions& d) { return {{}, {d.x, d.y, d.z}}; }
+
+    constexpr Dimensions size() const { return {{hi.x - lo.x, hi.y - lo.y, hi.z - lo.z}}; }
+    constexpr bool isEmpty() const { return hi.x <= lo.x || hi.y <= lo.y || hi.z <= lo.z; }
+
+    constexpr bool contains(const Region& r) const {
+        return lo.x <= r.lo.x && lo.y <= r.lo.y && lo.z <= r.lo.z && r.hi.x <= hi.x &&
+               r.hi.y <= hi.y && r.hi.z <= hi.z;
+    }
+
+    constexpr bool operator==(const Region& r) const { return contains(r) && r.contains(*this); }
+    constexpr bool operator!=(const Region& r) const { return !(*this == r); }
+};
+
 using VoxelSize = Vec3<float>;
 
 struct Voxel {
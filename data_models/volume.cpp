@@ -0,0 +1,49 @@
+#include "volume.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "parallel.hpp"
+
+namespace data_models {
+
+Volume
+Volume::downsampled(const int level) const {
+    assert(level >= 0 && isValid());
+
+    const int f = 1 << level;
+    const auto reduce = [f](const int n) { return std::max((n + f - 1) / f, 1); };
+    Volume out{{reduce(dim.x), reduce(dim.y), reduce(dim.z)}};
+    out.voxel_size = {voxel_size.x * f, voxel_size.y * f, voxel_size.z * f};
+
+    // One output slice per task. Blocks at the far edges are clipped to the dataset.
+    const auto [nx, ny, nz] = out.dim;
+    parallelFor(static_cast<size_t>(nz), [&](const size_t task) {
+        const int z = static_cast<int>(task);
+        const int z_end = std::min((z + 1) * f, dim.z);
+        for (int y = 0; y < ny; y++) {
+            const int y_end = std::min((y + 1) * f, dim.y);
+            for (int x = 0; x < nx; x++) {
+                const int x_end = std::min((x + 1) * f, dim.x);
+
+                uint32_t sum = 0;
+                for (int k = z * f; k < z_end; k++) {
+                    for (int j = y * f; j < y_end; j++) {
+                        const auto row = (static_cast<size_t>(k) * dim.y + j) * dim.x;
+                        for (int i = x * f; i < x_end; i++) {
+                            sum += buffer[row + i];
+                        }
+                    }
+                }
+
+                const uint32_t n = (x_end - x * f) * (y_end - y * f) * (z_end - z * f);
+                out.buffer[(static_cast<size_t>(z) * ny + y) * nx + x] =
+                    static_cast<uint8_t>((sum + n / 2) / n);
+            }
+        }
+    });
+
+    return out;
+}
+
+}  // namespace data_models
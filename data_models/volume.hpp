@@ -1,7 +1,8 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <vector>
 
+#include "buffer.hpp"
 #include "types.hpp"
 
 namespace data_models {
@@ -9,14 +10,18 @@ namespace data_models {
 struct Volume {
     types::Dimensions dim;
     types::VoxelSize voxel_size;
-    std::vector<uint8_t> buffer;
+    memory::Buffer buffer;
 
-    Volume(types::Dimensions d, types::VoxelSize vs, std::vector<uint8_t>&& b)
-        : dim{d}, voxel_size{vs}, buffer{b} {}
-    Volume(types::Dimensions d)
-        : dim{std::move(d)}, voxel_size{1.0f, 1.0f, 1.0f}, buffer(d.count()) {}
+    /** Take ownership of the voxels, without copying them. */
+    Volume(types::Dimensions d, types::VoxelSize vs, memory::Buffer&& b)
+        : dim{d}, voxel_size{vs}, buffer{std::move(b)} {}
+    Volume(types::Dimensions d, memory::Subsystem owner = memory::VOLUME)
+        : dim{d}, voxel_size{1.0f, 1.0f, 1.0f}, buffer{static_cast<size_t>(d.count()), owner} {}
 
     bool isValid() const { return buffer.size() == static_cast<size_t>(dim.count()); }
+
+    /** Average every block of 2^level voxels per axis into one, in parallel. */
+    Volume downsampled(int level) const;
 };
 
 }  // namespace data_models
\ No newline at end of file
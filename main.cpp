@@ -1,7 +1,16 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -11,9 +20,13 @@
 #include <GLFW/glfw3.h>  // Will drag system OpenGL headers
 
 #include "components/click_counter.hpp"
+#include "components/file_browser.hpp"
 #include "components/image_viewer.hpp"
+#include "components/memory_usage.hpp"
 #include "components/volume_viewer.hpp"
 #include "nifti-reader.h"
+#include "replay.h"
+#include "view_models/resource_cache.h"
 
 namespace {
 
@@ -24,6 +37,10 @@ using types::Orientation;
 using types::Voxel;
 using view_models::Frame2D;
 using view_models::Frame3D;
+using view_models::ResourceKey;
+using view_models::VolumeResource;
+
+constexpr float MiB = 1024.0f * 1024.0f;
 
 template <int W = 1024>
 Image
@@ -62,17 +79,204 @@ mockVolume() {
     return volume;
 }
 
+/** Move the voxels from the reader into the model; nothing is copied. */
 Volume
-toVolume(storage::NiftiReader file) {
+toVolume(storage::NiftiReader&& file) {
+    file.raw.transfer(memory::VOLUME);
     return {file.dimensions(), file.voxelSize(), std::move(file.raw)};
 }
 
+/** High water mark of the resident set, in bytes; 0 where unavailable. */
+size_t
+peakResidentBytes() {
+    size_t kib = 0;
+#ifdef __linux__
+    if (FILE* fp = fopen("/proc/self/status", "r"); fp != nullptr) {
+        char line[128]{};
+        while (fgets(line, sizeof(line), fp) != nullptr) {
+            if (sscanf(line, "VmHWM: %zu kB", &kib) == 1) {
+                break;
+            }
+        }
+        fclose(fp);
+    }
+#endif
+    return kib * 1024;
+}
+
+void
+logMemoryUsage(const char when[]) {
+    printf("Memory usage %s:\n", when);
+    for (int s = 0; s < memory::N_SUBSYSTEMS; s++) {
+        const auto& u = memory::usage[s];
+        const auto label = memory::name(static_cast<memory::Subsystem>(s));
+        printf("  %-8s %8.1f MiB (peak %8.1f MiB)\n", label, u.current / MiB, u.peak / MiB);
+    }
+    printf("  %-8s %8.1f MiB (peak %8.1f MiB)\n", "total", memory::total.current / MiB,
+           memory::total.peak / MiB);
+    printf("  %-8s %8.1f MiB\n", "peak RSS", peakResidentBytes() / MiB);
+}
+
 // Our state
 static ImVec4 clear_color = ImVec4(0.0f, 0.0f, 0.00f, 1.00f);
 
+/** Voxels and textures of every view; the budget is set from the command line. */
+static view_models::ResourceCache cache{0};
+static std::vector<std::unique_ptr<components::VolumeViewer>> views{};
+static size_t active_view{0};  // Where files picked in the browser are opened
+/** The view timelines are recorded from and replayed onto: the first, until it is closed. */
+static components::VolumeViewer* recorded_view{nullptr};
+static components::ImageViewer image_viewer{};
+
+/** The same file always maps to the same key, however it was named. */
+ResourceKey
+keyOf(const char path[], const int level = 0) {
+    return {std::filesystem::absolute(path).lexically_normal().string(), level};
+}
+
+/** Read a volume from disk, or downsample the full resolution one. Both go through the cache, so
+ * neither is repeated while the result stays resident. When a file has to be read, release is
+ * called once its header proved valid, just before its voxels are read. Requires a current GL
+ * context. */
+std::shared_ptr<const VolumeResource>
+loadVolume(const ResourceKey& key, const std::function<void()>& release = {}) {
+    return cache.volume(key, [&]() -> std::optional<Volume> {
+        if (key.level > 0) {
+            const auto full = loadVolume({key.source, 0}, release);
+            if (!full) {
+                return std::nullopt;
+            }
+            return full->volume.downsampled(key.level);
+        }
+
+        const auto path = key.source.c_str();
+        if (const auto header = storage::NiftiReader::openHeader(path); header.has_error) {
+            printf("Unable to decode %s; code = %d\n", path, header.error_code);
+            return std::nullopt;
+        }
+        if (release) {
+            release();
+        }
+
+        auto file = storage::NiftiReader::open(path);
+        if (file.has_error) {
+            printf("Unable to decode %s; code = %d\n", path, file.error_code);
+            return std::nullopt;
+        }
+        return toVolume(std::move(file.value));
+    });
+}
+
+/** Point a view at another volume. Should the new one fail to load, the view keeps showing the
+ * current one. Requires a current GL context. */
+void
+showVolume(components::VolumeViewer& view, const ResourceKey& key) {
+    // Let go of the current volume once the new file is known to be valid, yet before its voxels
+    // are read, so that the cache may evict it to make room.
+    const auto previous = view.key;
+    bool released = false;
+    auto resource = loadVolume(key, [&]() {
+        view.show({}, nullptr);
+        cache.trim();
+        released = true;
+    });
+
+    if (resource) {
+        view.show(key, std::move(resource));
+    } else if (released && !previous.source.empty()) {
+        // The voxels failed to read; bring the previous volume back if it is still cached.
+        const auto cached_only = []() -> std::optional<Volume> { return std::nullopt; };
+        if (auto restored = cache.volume(previous, cached_only)) {
+            view.show(previous, std::move(restored));
+        }
+    }
+    logMemoryUsage("after loading");
+}
+
+/** A new view next to the others, sharing the texture of the given volume. */
+void
+addView(const ResourceKey& key) {
+    auto& view = *views.emplace_back(std::make_unique<components::VolumeViewer>());
+    if (!key.source.empty()) {
+        showVolume(view, key);
+    }
+    active_view = views.size() - 1;
+}
+
+/** Act on what was picked in the last frame: closed views, switched datasets and opened files. */
 void
-MainLoopStep(GLFWwindow* window) {
+updateViews() {
+    if (recorded_view != nullptr && !recorded_view->open) {
+        recorded_view = nullptr;
+    }
+    views.erase(std::remove_if(views.begin(), views.end(), [](const auto& v) { return !v->open; }),
+                views.end());
+    active_view = std::min(active_view, views.empty() ? 0 : views.size() - 1);
+
+    for (auto& view : views) {
+        if (const auto key = view->takeRequest()) {
+            showVolume(*view, *key);
+        }
+    }
+
+    if (const auto path = components::FileBrowser::takeSelection()) {
+        if (views.empty()) {
+            addView({});
+        }
+        auto& view = *views[active_view];
+        showVolume(view, keyOf(path->c_str(), view.key.level));
+    }
+
+    // Views may have let go of their volumes.
+    cache.trim();
+}
+
+/** Timelines hold the settings of the first view only; once it is closed, there is nothing left
+ * to replay them onto. */
+std::optional<replay::ViewState>
+captureViewState(GLFWwindow* window) {
+    if (recorded_view == nullptr) {
+        return std::nullopt;
+    }
+
+    const auto& view = *recorded_view;
+    replay::ViewState state{view.orientation, view.alpha, view.volume_step_size, view.blend_mode,
+                            view.scale};
+    glfwGetWindowSize(window, &state.width, &state.height);
+    return state;
+}
+
+void
+applyViewState(GLFWwindow* window, const replay::ViewState& state) {
+    if (recorded_view != nullptr) {
+        auto& view = *recorded_view;
+        view.orientation = state.orientation;
+        view.alpha = state.alpha;
+        view.volume_step_size = state.volume_step_size;
+        view.blend_mode = state.blend_mode;
+        view.scale = state.scale;
+    }
+
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    if (width != state.width || height != state.height) {
+        glfwSetWindowSize(window, state.width, state.height);
+    }
+}
+
+void
+MainLoopStep(GLFWwindow* window, const bool auto_rotate) {
     using namespace components;
+
+    // Rotate before the sliders are drawn, so that the state left behind by this function is
+    // exactly the one rendered in this frame.
+    if (auto_rotate) {
+        for (auto& view : views) {
+            view->orientation.azimuth += 1;
+            view->orientation.normalize();
+        }
+    }
+
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -85,48 +289,41 @@ MainLoopStep(GLFWwindow* window) {
     {
         ImGui::Begin("Settings");
 
-        ImGui::Text("Blend mode");  // Display some text (you can use a format strings too)
-
-        {
-            using namespace types;
-            constexpr auto radioButton = [&](const char label[], const BlendMode value) {
-                auto& blend_mode = components::VolumeViewer::blend_mode;
-                if (ImGui::RadioButton(label, blend_mode == value)) {
-                    blend_mode = value;
-                }
-            };
-            radioButton("Normal", NORMAL);
-            ImGui::SameLine();
-            radioButton("Attenuate", ATTENUATE);
-            ImGui::SameLine();
-            radioButton("Max intensity", MAX_INTENSITY);
-        }
-
-        ImGui::SliderFloat("Scale", &view_models::scale, 0.0f, 10.0f);
-        ImGui::SliderFloat("alpha (coarse)", &VolumeViewer::alpha, 0.0f, 0.5f);
-        {
-            const float vmin = std::floor(VolumeViewer::alpha * 10.0f) / 10.0f;
-            const float vmax =
-                std::max(std::ceil(VolumeViewer::alpha * 10.0f) / 10.0f, vmin + 0.1f) - 0.01f;
-            ImGui::SliderFloat("alpha (fine)", &VolumeViewer::alpha, vmin, vmax);
-        }
-
-        constexpr float step_size_min = std::sqrt(0.5f);
-        ImGui::SliderFloat("Step size", &VolumeViewer::volume_step_size, step_size_min,
-                           5.0f);  // Edit 1 float using a slider from 0.0f to 1.0f
-        ImGui::SliderInt("azimuth", &VolumeViewer::orientation.azimuth, 0, 360);
-        ImGui::SliderInt("elevation", &VolumeViewer::orientation.elevation, -90, 90);
         ImGui::ColorEdit3("clear color",
                           (float*)&clear_color);  // Edit 3 floats representing a color
 
         ClickCounter::render();
 
+        if (ImGui::Button("Add view")) {
+            addView(views.empty() ? ResourceKey{} : views[active_view]->key);
+        }
+        ImGui::SameLine();
+        ImGui::Text("%zu views", views.size());
+
+        int budget_mib = static_cast<int>(cache.budgetBytes() / (1024 * 1024));
+        if (ImGui::SliderInt("Cache budget (MiB)", &budget_mib, 64, 16384)) {
+            cache.setBudget(static_cast<size_t>(budget_mib) * 1024 * 1024);
+        }
+        ImGui::Text("Cache: %zu resources, %.1f MiB", cache.size(), cache.residentBytes() / MiB);
+        MemoryUsage::render();
+
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate,
                     io.Framerate);
         ImGui::End();
     }
 
-    ImageViewer::render();
+    for (size_t i = 0; i < views.size(); i++) {
+        // Titles follow the position, while the ID after ### stays with the view.
+        char title[64]{};
+        snprintf(title, sizeof(title), "View %zu###%p", i + 1, (void*)views[i].get());
+        views[i]->renderControls(title, cache);
+        if (views[i]->focused) {
+            active_view = i;
+        }
+    }
+
+    image_viewer.render("New image");
+    FileBrowser::render();
 
     // Rendering
     ImGui::Render();
@@ -138,13 +335,18 @@ MainLoopStep(GLFWwindow* window) {
     {
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
+
+        // Side by side, each in a square viewport centered in its column.
+        const int n = std::max(static_cast<int>(views.size()), 1);
+        const int column = display_w / n;
+        const int size = std::min(column, display_h);
+        for (int i = 0; i < static_cast<int>(views.size()); i++) {
+            glViewport(i * column + (column - size) / 2, (display_h - size) / 2, size, size);
+            views[i]->render();
+        }
         glViewport(0, 0, display_w, display_h);
     }
 
-    VolumeViewer::render();
-    VolumeViewer::orientation.azimuth += 1;
-    VolumeViewer::orientation.normalize();
-
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
     glfwSwapBuffers(window);
@@ -179,20 +381,38 @@ struct GuiRuntime {
     }
 };
 
+/** Owns the teardown of everything holding GL objects. Declared after the window and the GUI
+ * runtime, so that it runs while the context is still current, on every way out of main. */
+struct Scene {
+    Scene() = default;
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    ~Scene() {
+        // Views first: they wait for their isosurface extractions, which use the worker pool.
+        recorded_view = nullptr;
+        views.clear();
+        image_viewer.frame.reset();
+        components::FileBrowser::entries.clear();
+        components::FileBrowser::index.reset();
+        cache.setBudget(0);
+    }
+};
+
 void
 glfw_error_callback(int error, const char* description) {
     fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
-enum fps_t { FPS60 = 1, FPS30 = 2 };
+enum fps_t { UNLIMITED = 0, FPS60 = 1, FPS30 = 2 };
 
 struct Window {
     GLFWwindow* fd;
 
-    Window()
+    Window(const fps_t fps = FPS30)
         : fd{glfwCreateWindow(1280, 1280, "Dear ImGui GLFW+OpenGL3 example", nullptr, nullptr)} {
         glfwMakeContextCurrent(fd);
-        glfwSwapInterval(FPS30);  // Enable vsync
+        glfwSwapInterval(fps);  // Enable vsync
     }
 
     ~Window() {
@@ -201,16 +421,146 @@ struct Window {
     }
 };
 
+struct Options {
+    const char* volume_path{nullptr};
+    const char* record_path{nullptr};
+    const char* replay_path{nullptr};
+    const char* baseline_path{nullptr};
+    const char* save_baseline_path{nullptr};
+    float threshold{1.1f};
+    size_t cache_budget_mib{1024};
+
+    bool parse(const int argc, char** argv) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            if (strncmp(arg, "--", 2) != 0) {
+                volume_path = arg;
+                continue;
+            }
+
+            if (i + 1 >= argc) {
+                return false;
+            }
+            const char* value = argv[++i];
+            if (strcmp(arg, "--record") == 0) {
+                record_path = value;
+            } else if (strcmp(arg, "--replay") == 0) {
+                replay_path = value;
+            } else if (strcmp(arg, "--baseline") == 0) {
+                baseline_path = value;
+            } else if (strcmp(arg, "--save-baseline") == 0) {
+                save_baseline_path = value;
+            } else if (strcmp(arg, "--threshold") == 0) {
+                threshold = std::strtof(value, nullptr);
+            } else if (strcmp(arg, "--cache-budget") == 0) {
+                cache_budget_mib = std::strtoul(value, nullptr, 10);
+            } else {
+                return false;
+            }
+        }
+
+        const bool replay_only = baseline_path != nullptr || save_baseline_path != nullptr;
+
+        // Saving first and comparing next against the same file would always pass.
+        const auto same_file = [](const char a[], const char b[]) {
+            namespace fs = std::filesystem;
+            return a != nullptr && b != nullptr &&
+                   fs::absolute(a).lexically_normal() == fs::absolute(b).lexically_normal();
+        };
+
+        return volume_path != nullptr && threshold > 0.0f &&
+               !(record_path != nullptr && replay_path != nullptr) &&
+               !(replay_only && replay_path == nullptr) &&
+               !same_file(baseline_path, save_baseline_path);
+    }
+};
+
+/** Render every frame of the timeline unattended, then report the frame time statistics. */
+int
+replayTimeline(GLFWwindow* window, const replay::Timeline& timeline, const Options& options) {
+    // The first frames pay for shader compilation and texture residency; keep them out of the
+    // statistics.
+    constexpr size_t warmup_frames = 10;
+    const size_t n_skipped = std::min(warmup_frames, timeline.size() / 2);
+
+    std::vector<float> frame_ms;
+    frame_ms.reserve(timeline.size());
+    for (size_t i = 0; i < timeline.size() && !glfwWindowShouldClose(window); i++) {
+        glfwPollEvents();
+        applyViewState(window, timeline[i]);
+
+        const auto start = std::chrono::steady_clock::now();
+        MainLoopStep(window, false);
+        glFinish();  // Wait for the GPU, otherwise we only time the command submission.
+        const std::chrono::duration<float, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        if (i >= n_skipped) {
+            frame_ms.push_back(elapsed.count());
+        }
+    }
+
+    const auto n_frames = frame_ms.size();
+    const auto stats = replay::summarize(frame_ms);
+    printf("Frame time over %zu frames (ms): p50 = %.3f, p95 = %.3f, p99 = %.3f\n", n_frames,
+           stats.p50, stats.p95, stats.p99);
+
+    if (options.save_baseline_path != nullptr &&
+        !replay::saveBaseline(stats, options.save_baseline_path)) {
+        printf("Unable to write baseline %s\n", options.save_baseline_path);
+        return 1;
+    }
+
+    if (options.baseline_path == nullptr) {
+        return 0;
+    }
+
+    const auto baseline = replay::loadBaseline(options.baseline_path);
+    if (baseline.has_error) {
+        printf("Unable to read baseline; code = %d\n", baseline.error_code);
+        return 1;
+    }
+
+    const auto& b = baseline.value;
+    printf("Baseline (ms): p50 = %.3f, p95 = %.3f, p99 = %.3f\n", b.p50, b.p95, b.p99);
+    if (!replay::withinBaseline(stats, b, options.threshold)) {
+        printf("FAIL: frame time exceeds baseline by more than %.0f%%\n",
+               (options.threshold - 1.0f) * 100.0f);
+        return 2;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
+
 }  // namespace
 
 int
 main(int argc, char** argv) {
-    if (argc <= 1) {
-        printf("Usage: %s path/to/nifti.nii.gz\n", argv[0]);
+    Options options{};
+    if (!options.parse(argc, argv)) {
+        printf("Usage: %s path/to/nifti.nii.gz [--record timeline.txt] [--cache-budget MiB]\n",
+               argv[0]);
+        printf(
+            "       %s path/to/nifti.nii.gz --replay timeline.txt [--baseline stats.txt] "
+            "[--threshold 1.1] [--save-baseline stats.txt]\n",
+            argv[0]);
         return 1;
     }
 
-    auto file = storage::NiftiReader::open(argv[1]);
+    replay::Timeline timeline{};
+    if (options.replay_path != nullptr) {
+        auto loaded = replay::loadTimeline(options.replay_path);
+        if (loaded.has_error) {
+            printf("Unable to read timeline; code = %d\n", loaded.error_code);
+            return 1;
+        }
+        timeline = std::move(loaded.value);
+    }
+    const bool replaying = !timeline.empty();
+
+    // Only validate the file here; the voxels go into the cache once there is a GL context.
+    const auto file = storage::NiftiReader::openHeader(options.volume_path);
     if (file.has_error) {
         printf("Unable to decode Nifti file; code = %d\n", file.error_code);
         return 1;
@@ -233,17 +583,36 @@ main(int argc, char** argv) {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 
+    if (replaying) {
+        // Offscreen, and not throttled by vsync, so that frame times measure the renderer.
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     // Create window with graphics context
-    Window window;
+    Window window{replaying ? UNLIMITED : FPS30};
     if (window.fd == nullptr) {
         return 1;
     }
 
     GuiRuntime gui_runtime{window.fd};
+    Scene scene{};
+
+    cache.setBudget(options.cache_budget_mib * 1024 * 1024);
+    image_viewer.frame = cache.image({"mock:image"}, []() { return mockImage(); });
+    // cache.volume({"mock:volume"}, []() { return mockVolume(); });
+    addView(keyOf(options.volume_path));
+    if (views.front()->resource == nullptr) {
+        // The header was fine, but the voxels were not; loadVolume printed why.
+        return 1;
+    }
+    recorded_view = views.front().get();
+
+    if (replaying) {
+        return replayTimeline(window.fd, timeline, options);
+    }
 
-    components::ImageViewer::frame.emplace(mockImage());
-    // components::VolumeViewer::volume.emplace(mockVolume());
-    components::VolumeViewer::volume.emplace(toVolume(std::move(file.value)));
+    components::FileBrowser::open(
+        std::filesystem::absolute(options.volume_path).parent_path().string());
 
     // Main loop
     while (!glfwWindowShouldClose(window.fd)) {
@@ -262,8 +631,24 @@ main(int argc, char** argv) {
             continue;
         }
 
-        MainLoopStep(window.fd);
+        MainLoopStep(window.fd, true);
+        if (options.record_path != nullptr) {
+            if (const auto state = captureViewState(window.fd)) {
+                timeline.push_back(*state);
+            }
+        }
+
+        updateViews();
+    }
+
+    if (options.record_path != nullptr) {
+        if (!replay::saveTimeline(timeline, options.record_path)) {
+            printf("Unable to write timeline %s\n", options.record_path);
+            return 1;
+        }
+        printf("Recorded %zu frames to %s\n", timeline.size(), options.record_path);
     }
 
+    logMemoryUsage("at exit");
     return 0;
 }
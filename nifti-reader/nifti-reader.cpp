@@ -2,6 +2,7 @@
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <memory>
@@ -25,14 +26,11 @@ struct GzFileWrapper {
 
 namespace storage {
 
-Expected<NiftiReader, Error>
-NiftiReader::open(const char filename[]) {
-    GzFileWrapper gz_file{filename};
-    const auto fp = gz_file.fp;
-    if (fp == nullptr) {
-        return CANNOT_OPEN_FILE;
-    }
+namespace {
 
+/** Read and validate the header, then seek to the first voxel. */
+Expected<NiftiReader, Error>
+readHeader(gzFile fp) {
     NiftiReader file{};
     const auto bytes_header_read = gzread(fp, &(file.header), sizeof(nifti_1_header));
     if (bytes_header_read != sizeof(nifti_1_header)) {
@@ -68,14 +66,74 @@ NiftiReader::open(const char filename[]) {
         return GZ_SEEK_FAILED;
     }
 
+    return file;
+}
+
+}  // namespace
+
+Expected<NiftiReader, Error>
+NiftiReader::open(const char filename[]) {
+    GzFileWrapper gz_file{filename};
+    const auto fp = gz_file.fp;
+    if (fp == nullptr) {
+        return CANNOT_OPEN_FILE;
+    }
+
+    auto result = readHeader(fp);
+    if (result.has_error) {
+        return Error{result.error_code};
+    }
+    auto& file = result.value;
+
     // Read the actual payload
-    file.raw.resize(n_voxels);
+    const auto n_voxels = file.dimensions().count();
+    file.raw = memory::Buffer{static_cast<size_t>(n_voxels), memory::READER};
     const auto bytes_read = gzread(fp, file.raw.data(), n_voxels * sizeof(uint8_t));
     if (bytes_read != static_cast<int>(n_voxels * sizeof(uint8_t))) {
         return VOXEL_READ_FAILED;
     }
 
-    return file;
+    return std::move(file);
+}
+
+Expected<NiftiReader, Error>
+NiftiReader::openHeader(const char filename[]) {
+    GzFileWrapper gz_file{filename};
+    if (gz_file.fp == nullptr) {
+        return CANNOT_OPEN_FILE;
+    }
+
+    return readHeader(gz_file.fp);
+}
+
+Expected<NiftiReader, Error>
+NiftiReader::stream(const char filename[], const int slab_depth, const SlabCallback& on_slab) {
+    GzFileWrapper gz_file{filename};
+    const auto fp = gz_file.fp;
+    if (fp == nullptr) {
+        return CANNOT_OPEN_FILE;
+    }
+
+    auto result = readHeader(fp);
+    if (result.has_error) {
+        return Error{result.error_code};
+    }
+
+    const auto [nx, ny, nz] = result.value.dimensions();
+    const auto slice_bytes = static_cast<size_t>(nx) * ny;
+    memory::Buffer slab{slice_bytes * std::min(slab_depth, nz), memory::READER};
+    for (int z = 0; z < nz; z += slab_depth) {
+        const int depth = std::min(slab_depth, nz - z);
+        const auto bytes = static_cast<int>(slice_bytes * depth);
+        if (gzread(fp, slab.data(), bytes) != bytes) {
+            return VOXEL_READ_FAILED;
+        }
+        if (!on_slab(slab.data(), z, depth)) {
+            return ABORTED;
+        }
+    }
+
+    return result;
 }
 
 types::Dimensions
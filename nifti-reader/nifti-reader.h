@@ -1,8 +1,10 @@
 #pragma once
 #include <cstdint>
+#include <functional>
 #include <utility>
-#include <vector>
 
+#include "data_models/buffer.hpp"
+#include "data_models/expected.hpp"
 #include "data_models/types.hpp"
 
 namespace storage {
@@ -16,19 +18,11 @@ enum Error {
     IMAGE_IS_COMPRESSED,
     GZ_SEEK_FAILED,
     VOXEL_READ_FAILED,
+    ABORTED,
 };
 
-template <typename T, typename U>
-struct Expected {
-    T value{};
-    U error_code{};
-    bool has_error{true};
+using types::Expected;
 
-    constexpr Expected(U&& ec) : error_code{ec}, has_error{true} {}
-
-    template <typename V>
-    constexpr Expected(V&& value) : value{std::forward<V>(value)}, has_error{false} {}
-};
 static_assert(sizeof(Expected<int, Error>) <= 16);
 
 struct nifti_1_header { /* NIFTI-1 usage         */     /* ANALYZE 7.5 field(s) */
@@ -80,13 +74,25 @@ struct nifti_1_header { /* NIFTI-1 usage         */     /* ANALYZE 7.5 field(s)
 class NiftiReader {
    public:
     nifti_1_header header{};
-    std::vector<uint8_t> raw{};
+    memory::Buffer raw{};
 
     NiftiReader& operator=(const NiftiReader&) = delete;
     NiftiReader(const NiftiReader&) = delete;
     NiftiReader(NiftiReader&&) noexcept = default;
 
+    /** Receives consecutive z-slices [z, z + depth) of the volume; returns false to stop. */
+    using SlabCallback = std::function<bool(const uint8_t* slab, int z, int depth)>;
+
     [[nodiscard]] static Expected<NiftiReader, Error> open(const char filename[]);
+
+    /** Validate and read the header only; raw stays empty. */
+    [[nodiscard]] static Expected<NiftiReader, Error> openHeader(const char filename[]);
+
+    /** Decode the voxels a few slices at a time, so that the whole volume never sits in memory.
+     * raw stays empty. Fails with ABORTED as soon as on_slab returns false. */
+    [[nodiscard]] static Expected<NiftiReader, Error> stream(const char filename[], int slab_depth,
+                                                             const SlabCallback& on_slab);
+
     [[nodiscard]] types::Dimensions dimensions() const;
     [[nodiscard]] types::VoxelSize voxelSize() const;
 };
@@ -0,0 +1,150 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+constexpr char timeline_header[]{"# volume-viewer timeline v1\n"};
+constexpr char baseline_header[]{"# volume-viewer baseline v1\n"};
+
+struct FileWrapper {
+    FILE* fp{};
+
+    FileWrapper(const char filename[], const char mode[]) : fp{fopen(filename, mode)} {}
+    FileWrapper& operator=(const FileWrapper&) = delete;
+    FileWrapper(const FileWrapper&) = delete;
+
+    ~FileWrapper() {
+        if (fp != nullptr) {
+            fclose(fp);
+        }
+    }
+};
+
+bool
+readHeader(FILE* fp, const char expected[]) {
+    char line[64]{};
+    return fgets(line, sizeof(line), fp) != nullptr && strcmp(line, expected) == 0;
+}
+
+/** Nearest-rank percentile of a sample set; reorders the samples. */
+float
+percentile(std::vector<float>& samples, const float p) {
+    const auto rank = static_cast<size_t>(std::ceil(p / 100.0f * samples.size()));
+    const auto nth = samples.begin() + (std::max<size_t>(rank, 1) - 1);
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+}  // namespace
+
+namespace replay {
+
+Expected<Timeline, Error>
+loadTimeline(const char filename[]) {
+    FileWrapper file{filename, "r"};
+    const auto fp = file.fp;
+    if (fp == nullptr) {
+        return CANNOT_OPEN_FILE;
+    }
+
+    if (!readHeader(fp, timeline_header)) {
+        return INVALID_HEADER;
+    }
+
+    Timeline timeline{};
+    while (true) {
+        ViewState s{};
+        int blend_mode{};
+        const auto n_fields =
+            fscanf(fp, "%d %d %f %f %d %f %d %d", &s.orientation.azimuth,
+                   &s.orientation.elevation, &s.alpha, &s.volume_step_size, &blend_mode,
+                   &s.scale, &s.width, &s.height);
+        if (n_fields == EOF) {
+            break;
+        }
+
+        const bool valid_blend_mode =
+            blend_mode >= types::NORMAL && blend_mode <= types::MAX_INTENSITY;
+        // Zero step size or scale would render nothing, and time nothing.
+        const bool renderable = s.volume_step_size > 0.0f && s.scale > 0.0f;
+        if (n_fields != 8 || !valid_blend_mode || !renderable || s.width <= 0 || s.height <= 0) {
+            return INVALID_RECORD;
+        }
+        s.blend_mode = static_cast<types::BlendMode>(blend_mode);
+        timeline.push_back(s);
+    }
+
+    if (timeline.empty()) {
+        return EMPTY_TIMELINE;
+    }
+    return timeline;
+}
+
+bool
+saveTimeline(const Timeline& timeline, const char filename[]) {
+    FileWrapper file{filename, "w"};
+    const auto fp = file.fp;
+    if (fp == nullptr) {
+        return false;
+    }
+
+    fputs(timeline_header, fp);
+    for (const auto& s : timeline) {
+        // %.9g round-trips a float exactly, so the replay renders bit-identical parameters.
+        fprintf(fp, "%d %d %.9g %.9g %d %.9g %d %d\n", s.orientation.azimuth,
+                s.orientation.elevation, s.alpha, s.volume_step_size, s.blend_mode, s.scale,
+                s.width, s.height);
+    }
+    return ferror(fp) == 0;
+}
+
+Expected<FrameStats, Error>
+loadBaseline(const char filename[]) {
+    FileWrapper file{filename, "r"};
+    const auto fp = file.fp;
+    if (fp == nullptr) {
+        return CANNOT_OPEN_FILE;
+    }
+
+    if (!readHeader(fp, baseline_header)) {
+        return INVALID_HEADER;
+    }
+
+    FrameStats stats{};
+    if (fscanf(fp, "%f %f %f", &stats.p50, &stats.p95, &stats.p99) != 3) {
+        return INVALID_RECORD;
+    }
+    return stats;
+}
+
+bool
+saveBaseline(const FrameStats& stats, const char filename[]) {
+    FileWrapper file{filename, "w"};
+    const auto fp = file.fp;
+    if (fp == nullptr) {
+        return false;
+    }
+
+    fputs(baseline_header, fp);
+    fprintf(fp, "%.6g %.6g %.6g\n", stats.p50, stats.p95, stats.p99);
+    return ferror(fp) == 0;
+}
+
+FrameStats
+summarize(std::vector<float>& frame_ms) {
+    if (frame_ms.empty()) {
+        return {};
+    }
+    return {percentile(frame_ms, 50.0f), percentile(frame_ms, 95.0f), percentile(frame_ms, 99.0f)};
+}
+
+bool
+withinBaseline(const FrameStats& current, const FrameStats& baseline, const float threshold) {
+    return current.p50 <= baseline.p50 * threshold && current.p95 <= baseline.p95 * threshold &&
+           current.p99 <= baseline.p99 * threshold;
+}
+
+}  // namespace replay
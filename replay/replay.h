@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+#include "data_models/expected.hpp"
+#include "data_models/types.hpp"
+
+namespace replay {
+
+enum Error {
+    CANNOT_OPEN_FILE,
+    INVALID_HEADER,
+    INVALID_RECORD,
+    EMPTY_TIMELINE,
+};
+
+using types::Expected;
+
+/** Every user-controllable parameter that affects the cost of one rendered frame. */
+struct ViewState {
+    types::Orientation orientation{};
+    float alpha{};
+    float volume_step_size{};
+    types::BlendMode blend_mode{types::ATTENUATE};
+    float scale{};
+    int width{};
+    int height{};
+};
+
+using Timeline = std::vector<ViewState>;
+
+/** Frame time percentiles, in milliseconds. */
+struct FrameStats {
+    float p50{};
+    float p95{};
+    float p99{};
+};
+
+[[nodiscard]] Expected<Timeline, Error> loadTimeline(const char filename[]);
+[[nodiscard]] bool saveTimeline(const Timeline& timeline, const char filename[]);
+
+[[nodiscard]] Expected<FrameStats, Error> loadBaseline(const char filename[]);
+[[nodiscard]] bool saveBaseline(const FrameStats& stats, const char filename[]);
+
+/** Summarize per-frame timings; the vector is reordered in place. */
+[[nodiscard]] FrameStats summarize(std::vector<float>& frame_ms);
+
+/** True if no percentile exceeds the baseline by more than the given ratio, e.g. 1.1 for +10%. */
+[[nodiscard]] bool withinBaseline(const FrameStats& current, const FrameStats& baseline,
+                                  float threshold);
+
+}  // namespace replay
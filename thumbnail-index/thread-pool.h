@@ -0,0 +1,69 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace storage {
+
+/** A fixed number of workers draining a FIFO job queue. Destruction drops the pending jobs and
+ * waits for the running ones. */
+class ThreadPool {
+   public:
+    explicit ThreadPool(const unsigned n_threads) {
+        for (unsigned i = 0; i < n_threads; i++) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+            jobs.clear();
+        }
+        wake.notify_all();
+
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard lock{mutex};
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+   private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    bool stopping{false};
+    std::vector<std::thread> workers;
+
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock{mutex};
+                wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+}  // namespace storage
@@ -0,0 +1,235 @@
+#include "thumbnail-index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+namespace fs = std::filesystem;
+using data_models::Image;
+
+namespace {
+
+struct FileWrapper {
+    FILE* fp{};
+
+    FileWrapper(const char filename[], const char mode[]) : fp{fopen(filename, mode)} {}
+    FileWrapper& operator=(const FileWrapper&) = delete;
+    FileWrapper(const FileWrapper&) = delete;
+
+    ~FileWrapper() {
+        if (fp != nullptr) {
+            fclose(fp);
+        }
+    }
+};
+
+bool
+isNifti(const fs::path& path) {
+    const auto name = path.filename().string();
+    const auto endsWith = [&](const std::string& suffix) {
+        return name.size() > suffix.size() &&
+               name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(".nii") || endsWith(".nii.gz");
+}
+
+/** $XDG_CACHE_HOME/volume-viewer/thumbnails, or an empty string to disable the cache. */
+std::string
+defaultCacheDir() {
+    fs::path root{};
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && xdg[0] != '\0') {
+        root = xdg;
+    } else if (const char* home = std::getenv("HOME"); home != nullptr && home[0] != '\0') {
+        root = fs::path{home} / ".cache";
+    } else {
+        return {};
+    }
+
+    const auto dir = root / "volume-viewer" / "thumbnails";
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    return ec ? std::string{} : dir.string();
+}
+
+/** Thumbnails are stored as binary PGM, viewable with any image viewer. */
+bool
+loadPgm(const std::string& filename, Image& image) {
+    FileWrapper file{filename.c_str(), "rb"};
+    const auto fp = file.fp;
+    if (fp == nullptr) {
+        return false;
+    }
+
+    int width, height, max_value;
+    if (fscanf(fp, "P5 %d %d %d", &width, &height, &max_value) != 3 || max_value != 255 ||
+        fgetc(fp) != '\n' || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    Image loaded{width, height};
+    if (fread(loaded.raw.data(), 1, loaded.raw.size(), fp) != loaded.raw.size()) {
+        return false;
+    }
+    image = std::move(loaded);
+    return true;
+}
+
+void
+savePgm(const std::string& filename, const Image& image) {
+    // Write aside, then rename, so that concurrent viewers never read a partial file.
+    const auto partial = filename + ".partial";
+    {
+        FileWrapper file{partial.c_str(), "wb"};
+        const auto fp = file.fp;
+        if (fp == nullptr) {
+            return;
+        }
+        fprintf(fp, "P5\n%d %d\n255\n", image.width, image.height);
+        fwrite(image.raw.data(), 1, image.raw.size(), fp);
+        if (ferror(fp) != 0) {
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(partial, filename, ec);
+}
+
+}  // namespace
+
+namespace storage {
+
+ThumbnailIndex::ThumbnailIndex(const std::string& directory)
+    : cache_dir{defaultCacheDir()},
+      // Leave one core to the render loop.
+      pool{std::max(2u, std::thread::hardware_concurrency()) - 1} {
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator{directory, ec}) {
+        if (entry.is_regular_file(ec) && isNifti(entry.path())) {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // The queue is FIFO: every header is read before the first projection starts.
+    for (size_t i = 0; i < paths.size(); i++) {
+        pool.submit([this, i]() { readHeader(i); });
+    }
+}
+
+std::vector<Thumbnail>
+ThumbnailIndex::poll() {
+    std::vector<Thumbnail> thumbnails{};
+    std::lock_guard lock{mutex};
+    thumbnails.swap(completed);
+    return thumbnails;
+}
+
+void
+ThumbnailIndex::publish(Thumbnail&& thumbnail) {
+    std::lock_guard lock{mutex};
+    completed.push_back(std::move(thumbnail));
+}
+
+std::string
+ThumbnailIndex::cacheFile(const size_t index) const {
+    if (cache_dir.empty()) {
+        return {};
+    }
+
+    // Key on the location and the version of the file.
+    std::error_code ec;
+    const fs::path path{paths[index]};
+    const auto size = fs::file_size(path, ec);
+    if (ec) {
+        return {};
+    }
+    const auto modified = fs::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) {
+        return {};
+    }
+    const auto absolute = fs::absolute(path, ec).string();
+    if (ec) {
+        return {};
+    }
+
+    const auto key = absolute + '\n' + std::to_string(size) + '\n' + std::to_string(modified) +
+                     '\n' + std::to_string(thumbnail_size);
+    char name[32]{};
+    snprintf(name, sizeof(name), "%016zx.pgm", std::hash<std::string>{}(key));
+    return (fs::path{cache_dir} / name).string();
+}
+
+void
+ThumbnailIndex::readHeader(const size_t index) {
+    auto file = NiftiReader::openHeader(paths[index].c_str());
+    if (file.has_error) {
+        publish({index, {}, file.error_code, true});
+        return;
+    }
+
+    Thumbnail thumbnail{index, file.value.dimensions()};
+    if (const auto cached = cacheFile(index); !cached.empty() && loadPgm(cached, thumbnail.mip)) {
+        publish(std::move(thumbnail));
+        return;
+    }
+
+    const auto dim = thumbnail.dim;
+    publish(std::move(thumbnail));
+    pool.submit([this, index, dim]() { project(index, dim); });
+}
+
+void
+ThumbnailIndex::project(const size_t index, const types::Dimensions dim) {
+    const auto [nx, ny, nz] = dim;
+    const int shrink = std::max(1, (std::max(nx, ny) + thumbnail_size - 1) / thumbnail_size);
+    Image mip{(nx + shrink - 1) / shrink, (ny + shrink - 1) / shrink};
+
+    // About 1 MiB of decoded voxels at a time.
+    const auto slice_bytes = static_cast<size_t>(nx) * ny;
+    const int slab_depth = static_cast<int>(std::max<size_t>(1, (size_t{1} << 20) / slice_bytes));
+
+    const auto file = NiftiReader::stream(
+        paths[index].c_str(), slab_depth, [&](const uint8_t* slab, int /*z*/, const int depth) {
+            for (int k = 0; k < depth; k++) {
+                for (int y = 0; y < ny; y++) {
+                    // Flip vertically: rows are drawn top down, the volume's y axis points up.
+                    auto* dst = &mip.raw[static_cast<size_t>(mip.height - 1 - y / shrink) *
+                                         mip.width];
+                    const auto* src = &slab[(static_cast<size_t>(k) * ny + y) * nx];
+                    for (int x = 0; x < nx; x++) {
+                        dst[x / shrink] = std::max(dst[x / shrink], src[x]);
+                    }
+                }
+            }
+            return !stopping;
+        });
+    if (file.has_error && file.error_code == ABORTED) {
+        return;
+    }
+    if (file.has_error) {
+        publish({index, dim, file.error_code, true});
+        return;
+    }
+
+    // Stretch the contrast, since dim volumes would otherwise be indistinguishable.
+    const auto vmax = *std::max_element(mip.raw.begin(), mip.raw.end());
+    if (vmax > 0) {
+        for (auto& v : mip.raw) {
+            v = static_cast<uint8_t>(v * 255 / vmax);
+        }
+    }
+
+    if (const auto cached = cacheFile(index); !cached.empty()) {
+        savePgm(cached, mip);
+    }
+
+    Thumbnail thumbnail{index, dim};
+    thumbnail.mip = std::move(mip);
+    publish(std::move(thumbnail));
+}
+
+}  // namespace storage
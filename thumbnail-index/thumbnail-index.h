@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "data_models/image.hpp"
+#include "data_models/types.hpp"
+#include "nifti-reader.h"
+#include "thread-pool.h"
+
+namespace storage {
+
+/** Maximum intensity projection of a volume along z, shrunk to a preview. */
+struct Thumbnail {
+    size_t index{};  // Into ThumbnailIndex::files()
+    types::Dimensions dim{};
+    Error error_code{};
+    bool has_error{false};
+    data_models::Image mip{0, 0};  // Empty while only the header is known
+};
+
+/** Generates the thumbnails of every NIfTI volume in a directory in the background. All headers
+ * are read first; then every file streams through a projection slab by slab, so that no volume
+ * is ever held in memory as a whole. Projections are cached on disk. Destruction abandons the
+ * projections in progress after their current slab. */
+class ThumbnailIndex {
+   public:
+    static constexpr int thumbnail_size = 128;
+
+    explicit ThumbnailIndex(const std::string& directory);
+    ~ThumbnailIndex() { stopping = true; }
+
+    ThumbnailIndex(const ThumbnailIndex&) = delete;
+    ThumbnailIndex& operator=(const ThumbnailIndex&) = delete;
+
+    [[nodiscard]] const std::vector<std::string>& files() const { return paths; }
+
+    /** Headers and thumbnails completed since the last call. */
+    [[nodiscard]] std::vector<Thumbnail> poll();
+
+   private:
+    std::vector<std::string> paths;
+    std::string cache_dir;
+
+    std::mutex mutex;
+    std::vector<Thumbnail> completed;
+
+    std::atomic<bool> stopping{false};
+
+    // Last member, so that the workers stop before anything they use is destroyed.
+    ThreadPool pool;
+
+    void readHeader(size_t index);
+    void project(size_t index, types::Dimensions dim);
+    void publish(Thumbnail&& thumbnail);
+    [[nodiscard]] std::string cacheFile(size_t index) const;
+};
+
+}  // namespace storage
@@ -0,0 +1,117 @@
+#include "resource_cache.h"
+
+using data_models::Image;
+using data_models::Volume;
+
+namespace view_models {
+
+std::shared_ptr<const VolumeResource>
+ResourceCache::volume(const ResourceKey& key, const VolumeLoader& load) {
+    const std::type_index type = typeid(VolumeResource);
+    if (auto cached = find(type, key)) {
+        return std::static_pointer_cast<const VolumeResource>(cached);
+    }
+
+    auto loaded = load();
+    if (!loaded) {
+        return nullptr;
+    }
+
+    auto resource = std::make_shared<const VolumeResource>(std::move(*loaded));
+    insert(type, key, resource, resource->bytes());
+    return resource;
+}
+
+std::shared_ptr<const Frame2D>
+ResourceCache::image(const ResourceKey& key, const ImageLoader& load) {
+    const std::type_index type = typeid(Frame2D);
+    if (auto cached = find(type, key)) {
+        return std::static_pointer_cast<const Frame2D>(cached);
+    }
+
+    auto loaded = load();
+    if (!loaded) {
+        return nullptr;
+    }
+
+    auto resource = std::make_shared<const Frame2D>(std::move(*loaded));
+    const auto bytes = static_cast<size_t>(resource->width) * resource->height;
+    insert(type, key, resource, bytes);
+    return resource;
+}
+
+std::shared_ptr<const Frame3D>
+ResourceCache::texture(const ResourceKey& key, const Volume& volume, const ResourceKey& previous) {
+    const std::type_index type = typeid(Frame3D);
+    if (auto cached = find(type, key)) {
+        return std::static_pointer_cast<const Frame3D>(cached);
+    }
+
+    std::shared_ptr<Frame3D> frame{};
+    const auto reusable = index.find({type, previous});
+    if (reusable != index.end() && previous.source == key.source &&
+        previous.level == key.level && reusable->second->resource.use_count() == 1) {
+        // Only the cache made textures, so they are not const objects.
+        frame = std::const_pointer_cast<Frame3D>(
+            std::static_pointer_cast<const Frame3D>(reusable->second->resource));
+        resident -= reusable->second->bytes;
+        entries.erase(reusable->second);
+        index.erase(reusable);
+        frame->setRegion(volume, key.region);
+    } else {
+        frame = std::make_shared<Frame3D>(volume, key.region);
+    }
+
+    const auto [x, y, z] = frame->window.size();
+    insert(type, key, frame, static_cast<size_t>(x) * y * z);
+    return frame;
+}
+
+std::vector<ResourceKey>
+ResourceCache::volumes() const {
+    std::vector<ResourceKey> keys;
+    for (const auto& e : entries) {
+        if (e.type == typeid(VolumeResource)) {
+            keys.push_back(e.key);
+        }
+    }
+    return keys;
+}
+
+void
+ResourceCache::trim() {
+    for (auto it = entries.end(); it != entries.begin() && resident > budget;) {
+        --it;
+        if (it->resource.use_count() > 1) {
+            continue;  // Held by a viewer
+        }
+
+        resident -= it->bytes;
+        index.erase({it->type, it->key});
+        it = entries.erase(it);
+    }
+}
+
+std::shared_ptr<const void>
+ResourceCache::find(const std::type_index type, const ResourceKey& key) {
+    const auto found = index.find({type, key});
+    if (found == index.end()) {
+        return nullptr;
+    }
+
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->resource;
+}
+
+void
+ResourceCache::insert(const std::type_index type, const ResourceKey& key,
+                      std::shared_ptr<const void> resource, const size_t bytes) {
+    entries.push_front({type, key, std::move(resource), bytes});
+    index.emplace(std::make_pair(type, key), entries.begin());
+    resident += bytes;
+
+    // The caller still holds the new resource, so it is never the one evicted.
+    trim();
+}
+
+}  // namespace view_models
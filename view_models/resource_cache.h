@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "data_models/frame2d.h"
+#include "data_models/frame3d.h"
+#include "data_models/image.hpp"
+#include "data_models/types.hpp"
+#include "data_models/volume.hpp"
+
+namespace view_models {
+
+struct ResourceKey {
+    std::string source;      // File path, or the name of generated data
+    int level{0};            // Every level halves the resolution along each axis
+    types::Region region{};  // Voxels of a texture; empty for everything else
+
+    auto tied() const {
+        const auto& [lo, hi] = region;
+        return std::tie(source, level, lo.x, lo.y, lo.z, hi.x, hi.y, hi.z);
+    }
+
+    bool operator<(const ResourceKey& k) const { return tied() < k.tied(); }
+    bool operator==(const ResourceKey& k) const { return tied() == k.tied(); }
+};
+
+/** Voxels kept in memory for cropping, downsampling and surface extraction. */
+struct VolumeResource {
+    data_models::Volume volume;
+
+    explicit VolumeResource(data_models::Volume&& v) : volume{std::move(v)} {}
+
+    size_t bytes() const { return volume.buffer.size(); }
+};
+
+/** Volumes and textures shared between viewers, keyed by source and level, and textures also by
+ * region. A resource stays resident as long as a viewer holds it; the others are evicted, least
+ * recently used first, once the cache exceeds its budget. Requires a current GL context, and must
+ * only be used from its thread. */
+class ResourceCache {
+   public:
+    using VolumeLoader = std::function<std::optional<data_models::Volume>()>;
+    using ImageLoader = std::function<std::optional<data_models::Image>()>;
+
+    explicit ResourceCache(size_t budget_bytes) : budget{budget_bytes} {}
+
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+
+    /** The cached resource, or else upload what the loader returns; nullptr if the loader fails. */
+    std::shared_ptr<const VolumeResource> volume(const ResourceKey& key, const VolumeLoader& load);
+    std::shared_ptr<const Frame2D> image(const ResourceKey& key, const ImageLoader& load);
+
+    /** The texture of key.region of a volume, shared between views cropped alike. On a miss, the
+     * texture cached as previous is resized in place when no viewer holds it any more, so that a
+     * dragged crop box only uploads the voxels coming into view; otherwise a new one is made. */
+    std::shared_ptr<const Frame3D> texture(const ResourceKey& key,
+                                           const data_models::Volume& volume,
+                                           const ResourceKey& previous = {});
+
+    /** Keys of the cached volumes, most recently used first. */
+    std::vector<ResourceKey> volumes() const;
+
+    /** Evict the least recently used resources that no viewer holds, until within budget. */
+    void trim();
+
+    void setBudget(size_t bytes) {
+        budget = bytes;
+        trim();
+    }
+    size_t budgetBytes() const { return budget; }
+    size_t residentBytes() const { return resident; }
+    size_t size() const { return entries.size(); }
+
+   private:
+    struct Entry {
+        std::type_index type;
+        ResourceKey key;
+        std::shared_ptr<const void> resource;
+        size_t bytes;
+    };
+
+    using Entries = std::list<Entry>;  // Most recently used first
+    Entries entries{};
+    std::map<std::pair<std::type_index, ResourceKey>, Entries::iterator> index{};
+    size_t budget;
+    size_t resident{0};
+
+    std::shared_ptr<const void> find(std::type_index type, const ResourceKey& key);
+    void insert(std::type_index type, const ResourceKey& key, std::shared_ptr<const void> resource,
+                size_t bytes);
+};
+
+}  // namespace view_models
@@ -1,6 +0,0 @@
-#pragma once
-
-namespace view_models {
-
-static float scale{1.0f};
-}
\ No newline at end of file